@@ -21,17 +21,62 @@ DEFINES += QT_DEPRECATED_WARNINGS
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    analysisqueue.cpp \
+    analysisworker.cpp \
+    audiochunkcache.cpp \
+    audioengine.cpp \
+    beatanalyzer.cpp \
+    beatworker.cpp \
+    equalizerdialog.cpp \
+    fingerprintindex.cpp \
+    fingerprintworker.cpp \
+    loudnessscanner.cpp \
+    loudnessworker.cpp \
     lyricswidget.cpp \
     main.cpp \
     mainwindow.cpp \
+    meterwidget.cpp \
+    mpveventchannel.cpp \
+    mpveventloop.cpp \
     mpvplayer.cpp \
-    networkmanager.cpp
+    networkmanager.cpp \
+    playbackclock.cpp \
+    remoteplayer.cpp \
+    searchlistparser.cpp \
+    seekslider.cpp \
+    syncsession.cpp \
+    waveformgenerator.cpp \
+    waveformworker.cpp
 
 HEADERS += \
+    analysisqueue.h \
+    analysisworker.h \
+    audiochunkcache.h \
+    audioengine.h \
+    audioplayer.h \
+    beatanalyzer.h \
+    beatworker.h \
+    engineprotocol.h \
+    equalizerdialog.h \
+    fingerprintindex.h \
+    fingerprintworker.h \
+    loudnessscanner.h \
+    loudnessworker.h \
     lyricswidget.h \
     mainwindow.h \
+    meterwidget.h \
+    mpveventchannel.h \
+    mpveventloop.h \
     mpvplayer.h \
-    networkmanager.h
+    networkmanager.h \
+    playbackclock.h \
+    remoteplayer.h \
+    searchlistparser.h \
+    seekslider.h \
+    spscqueue.h \
+    syncsession.h \
+    waveformgenerator.h \
+    waveformworker.h
 
 FORMS += \
     mainwindow.ui
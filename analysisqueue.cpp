@@ -0,0 +1,133 @@
+/**
+ * @brief   : 后台分析公共调度实现
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#include "analysisqueue.h"
+#include "analysisworker.h"
+#include "audiochunkcache.h"
+
+AnalysisQueue::AnalysisQueue(AudioChunkCache *cache, QObject *parent)
+    : QObject(parent),
+      m_cache(cache),
+      m_paused(0),
+      m_quit(0),
+      m_active(0)
+{
+    m_yieldTimer.setSingleShot(true);
+    connect(&m_yieldTimer, &QTimer::timeout, this, &AnalysisQueue::onYieldTimeout);
+}
+
+AnalysisQueue::~AnalysisQueue()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_quit.storeRelease(1);
+        m_cond.wakeAll();
+    }
+    // 正在处理的线程在下一次轮询时发现退出标志；线程只访问本类的状态，子类此时已析构也无妨
+    for (AnalysisWorker *worker : m_workers) {
+        worker->wait();
+        delete worker;
+    }
+}
+
+void AnalysisQueue::startWorkers(int count)
+{
+    for (int i = 0; i < count; ++i) {
+        AnalysisWorker *worker = createWorker();
+        worker->start(QThread::IdlePriority);
+        m_workers.append(worker);
+    }
+}
+
+void AnalysisQueue::enqueue(int songId, bool urgent)
+{
+    if (m_workers.isEmpty() || m_failed.contains(songId)) return;
+    if (m_resolving.contains(songId) || m_processing.contains(songId)) return;
+    if (!urgent && m_waiting.contains(songId)) return;
+    if (isDone(songId)) return;
+
+    m_waiting.removeOne(songId);
+    if (urgent) m_waiting.prepend(songId);
+    else m_waiting.append(songId);
+    pump();
+}
+
+void AnalysisQueue::provideSongUrl(int songId, const QString &url)
+{
+    if (!m_resolving.remove(songId)) return;
+    if (url.isEmpty()) {
+        m_failed.insert(songId);
+        pump();
+        return;
+    }
+
+    // 经由分块缓存读取：分析下载的分块之后播放直接用
+    QString target = url;
+    if (m_cache) {
+        m_cache->setSource(songId, url);
+        target = AudioChunkCache::streamUrl(songId);
+    }
+    m_processing.insert(songId);
+
+    QMutexLocker lock(&m_mutex);
+    m_ready.enqueue(Job{songId, target});
+    m_cond.wakeOne();
+}
+
+void AnalysisQueue::yield(int ms)
+{
+    if (m_workers.isEmpty()) return;
+    m_paused.storeRelease(1);
+    m_yieldTimer.start(ms);
+}
+
+void AnalysisQueue::onYieldTimeout()
+{
+    m_paused.storeRelease(0);
+    pump();
+}
+
+/*-------------------------------
+ * 同一时间请求地址的歌曲数不超过空闲线程数：
+ * 地址拿到就能马上开始处理，不会在队列里放到过期
+ *------------------------------*/
+void AnalysisQueue::pump()
+{
+    if (m_workers.isEmpty() || isPaused()) return;
+
+    int busy;
+    {
+        QMutexLocker lock(&m_mutex);
+        busy = m_active + m_ready.size();
+    }
+    while (busy + m_resolving.size() < m_workers.size() && !m_waiting.isEmpty()) {
+        int songId = m_waiting.takeFirst();
+        if (isDone(songId)) continue;
+        m_resolving.insert(songId);
+        emit songUrlRequested(songId);
+    }
+}
+
+bool AnalysisQueue::takeJob(Job &job)
+{
+    QMutexLocker lock(&m_mutex);
+    while (m_ready.isEmpty() && !isQuitting()) m_cond.wait(&m_mutex);
+    if (isQuitting()) return false;
+    job = m_ready.dequeue();
+    ++m_active;
+    return true;
+}
+
+void AnalysisQueue::onJobFinished(int songId, bool ok, const QVariant &result)
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        --m_active;
+    }
+    m_processing.remove(songId);
+
+    if (!ok || !jobFinished(songId, result)) m_failed.insert(songId);
+    pump();
+}
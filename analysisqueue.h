@@ -0,0 +1,91 @@
+/**
+ * @brief   : 后台分析的公共调度：等待队列、按需解析地址、经由分块缓存读取、让出与退出，
+ *            响度扫描、波形、节拍、声纹都在此之上只实现各自的处理和结果存储
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#ifndef ANALYSISQUEUE_H
+#define ANALYSISQUEUE_H
+
+#include <QObject>
+#include <QList>
+#include <QSet>
+#include <QQueue>
+#include <QTimer>
+#include <QVariant>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+
+class AudioChunkCache;
+class AnalysisWorker;
+
+/*
+ * 地址在真正开始处理前才请求（songUrlRequested），不会因为排队太久而过期；
+ * 同一时间请求地址的歌曲数不超过空闲线程数。处理经由分块缓存读取，
+ * 分析过的歌曲播放时不再下载，反之亦然。线程以最低优先级运行，可以让出。
+ */
+class AnalysisQueue : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AnalysisQueue(AudioChunkCache *cache, QObject *parent = nullptr);
+    ~AnalysisQueue();
+
+    // 加入等待队列；已有结果的直接忽略，urgent 排到最前（即将播放的曲目）
+    void enqueue(int songId, bool urgent = false);
+    void provideSongUrl(int songId, const QString &url); // 地址为空表示解析失败，本次运行不再重试
+
+    // 让出 ms 毫秒：起播、续播等需要网络和 CPU 的时刻暂停处理和新的地址请求，重复调用以最后一次为准
+    void yield(int ms);
+
+signals:
+    void songUrlRequested(int songId);
+
+protected:
+    // 由子类构造函数最后调用：此时虚函数已就绪；count 为 0 表示不分析
+    void startWorkers(int count);
+
+    virtual AnalysisWorker *createWorker() = 0;
+    // 已有结果（缓存文件等），不必再排队
+    virtual bool isDone(int songId) const = 0;
+    // 处理成功后在本线程调用，result 由分析线程给出；返回 false 视为失败
+    virtual bool jobFinished(int songId, const QVariant &result) = 0;
+
+    AudioChunkCache *m_cache;
+
+private slots:
+    void onJobFinished(int songId, bool ok, const QVariant &result);
+    void onYieldTimeout();
+
+private:
+    friend class AnalysisWorker;
+    struct Job {
+        int songId;
+        QString url;
+    };
+
+    // 以下由分析线程调用
+    bool takeJob(Job &job);            // 阻塞到有任务；返回 false 表示退出
+    bool isPaused() const { return m_paused.loadAcquire() != 0; }
+    bool isQuitting() const { return m_quit.loadAcquire() != 0; }
+
+    void pump(); // 有空闲的分析线程时为队首歌曲请求地址
+
+    QList<AnalysisWorker *> m_workers;
+    QList<int> m_waiting;      // 等待处理的歌曲
+    QSet<int> m_resolving;     // 已请求地址
+    QSet<int> m_processing;    // 已交给分析线程（排队或正在处理）
+    QSet<int> m_failed;        // 本次运行中失败过的，不再排队
+    QTimer m_yieldTimer;
+    QAtomicInt m_paused;
+    QAtomicInt m_quit;
+
+    // 分析线程共享
+    QMutex m_mutex;
+    QWaitCondition m_cond;
+    QQueue<Job> m_ready;       // 已拿到地址、等待空闲线程
+    int m_active;              // 正在处理的任务数
+};
+
+#endif // ANALYSISQUEUE_H
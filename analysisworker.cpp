@@ -0,0 +1,39 @@
+/**
+ * @brief   : 后台分析线程公共部分实现
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#include "analysisworker.h"
+#include "analysisqueue.h"
+
+AnalysisWorker::AnalysisWorker(AnalysisQueue *queue, AudioChunkCache *cache)
+    : QThread(nullptr),
+      m_cache(cache),
+      m_queue(queue)
+{
+}
+
+void AnalysisWorker::run()
+{
+    if (!prepare()) return;
+
+    AnalysisQueue::Job job;
+    while (m_queue->takeJob(job)) {
+        QVariant result;
+        bool ok = process(job.songId, job.url, result);
+        QMetaObject::invokeMethod(m_queue, "onJobFinished", Qt::QueuedConnection,
+                                  Q_ARG(int, job.songId), Q_ARG(bool, ok), Q_ARG(QVariant, result));
+    }
+
+    finish();
+}
+
+bool AnalysisWorker::isQuitting() const
+{
+    return m_queue->isQuitting();
+}
+
+bool AnalysisWorker::isPaused() const
+{
+    return m_queue->isPaused();
+}
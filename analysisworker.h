@@ -0,0 +1,45 @@
+/**
+ * @brief   : 后台分析线程的公共部分：从调度队列取任务、处理、把结果交回界面线程
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#ifndef ANALYSISWORKER_H
+#define ANALYSISWORKER_H
+
+#include <QThread>
+#include <QVariant>
+
+class AnalysisQueue;
+class AudioChunkCache;
+
+/*
+ * 线程以 IdlePriority 启动（Linux 上为 SCHED_IDLE），在本线程里创建的 mpv 内核
+ * 继承同样的调度策略，有播放在跑时只用空闲的 CPU。
+ */
+class AnalysisWorker : public QThread
+{
+    Q_OBJECT
+public:
+    AnalysisWorker(AnalysisQueue *queue, AudioChunkCache *cache);
+
+protected:
+    void run() override;
+
+    // 取任务之前调用一次（创建内核、装入索引等）；返回 false 时线程直接结束
+    virtual bool prepare() { return true; }
+    // 处理一首歌；result 原样交给 AnalysisQueue::jobFinished
+    virtual bool process(int songId, const QString &url, QVariant &result) = 0;
+    // 线程结束前调用一次
+    virtual void finish() {}
+
+    // 处理过程中轮询：退出时尽快返回，暂停期间停止解码
+    bool isQuitting() const;
+    bool isPaused() const;
+
+    AudioChunkCache *m_cache;
+
+private:
+    AnalysisQueue *m_queue;
+};
+
+#endif // ANALYSISWORKER_H
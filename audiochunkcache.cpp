@@ -0,0 +1,374 @@
+/**
+ * @brief   : 稀疏分块音频缓存实现
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#include "audiochunkcache.h"
+#include "networkmanager.h"
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QDeadlineTimer>
+#include <QDebug>
+
+static const char kProtocol[] = "mcache";
+static const qint64 kChunkSize = 256 * 1024;           // 分块大小
+static const int kReadaheadChunks = 4;                 // 读到第 n 块时预取后面几块
+static const qint64 kMaxCacheBytes = 256LL * 1024 * 1024; // 内存上限，超出按最久未用淘汰整首
+static const unsigned long kReadTimeoutMs = 20000;     // 单块等待上限，超时让 mpv 报错走续播
+
+AudioChunkCache::AudioChunkCache(NetworkManager *net, QObject *parent)
+    : QObject(parent),
+      m_net(net),
+      m_totalBytes(0),
+      m_useCounter(0)
+{
+}
+
+QString AudioChunkCache::streamUrl(int songId)
+{
+    return QString("%1://%2").arg(kProtocol).arg(songId);
+}
+
+void AudioChunkCache::registerWith(mpv_handle *mpv)
+{
+    if (mpv_stream_cb_add_ro(mpv, kProtocol, this, &AudioChunkCache::openFn) < 0) {
+        qWarning() << "mpv_stream_cb_add_ro failed";
+    }
+}
+
+void AudioChunkCache::setSource(int songId, const QString &url)
+{
+    QMutexLocker lock(&m_mutex);
+    // 已合并的重复歌曲内容相同，它的地址同样可以用来补齐共用的分块
+    int key = keyLocked(songId);
+    Track &t = m_tracks[key];
+    t.url = url;
+    // 新地址可以重试之前失败的分块
+    t.failed.clear();
+    t.refreshing = false;
+    const QSet<qint64> stalled = t.stalled;
+    t.stalled.clear();
+    if (url.isEmpty()) {
+        // 重新解析也失败了：等待的读取按下载失败处理
+        t.failed += stalled;
+        m_cond.wakeAll();
+        return;
+    }
+    for (qint64 chunk : stalled) requestChunkLocked(key, t, chunk);
+}
+
+void AudioChunkCache::setDuplicate(int songId, int canonicalId)
+{
+    QMutexLocker lock(&m_mutex);
+    if (songId == canonicalId || m_aliases.contains(songId)) return;
+    m_pendingDuplicates.insert(songId, canonicalId);
+    mergeDuplicatesLocked();
+}
+
+qint64 AudioChunkCache::cachedBytes() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_totalBytes;
+}
+
+/*===============================
+ * mpv stream_cb 回调
+ *==============================*/
+int AudioChunkCache::openFn(void *userData, char *uri, mpv_stream_cb_info *info)
+{
+    AudioChunkCache *self = static_cast<AudioChunkCache *>(userData);
+    QString s = QString::fromUtf8(uri);
+    QMutexLocker lock(&self->m_mutex);
+    int songId = self->keyLocked(s.mid(s.indexOf("://") + 3).toInt());
+    auto it = self->m_tracks.find(songId);
+    if (it == self->m_tracks.end() || it->url.isEmpty()) {
+        return MPV_ERROR_LOADING_FAILED;
+    }
+    it->openCount++;
+    it->lastUse = ++self->m_useCounter;
+
+    Stream *stream = new Stream{self, songId, 0, false};
+
+    // 首块决定文件大小，mpv 打开时就需要
+    if (!self->waitForChunkLocked(stream, 0)) {
+        self->m_tracks[songId].openCount--;
+        delete stream;
+        return MPV_ERROR_LOADING_FAILED;
+    }
+
+    info->cookie = stream;
+    info->read_fn = &AudioChunkCache::readFn;
+    info->seek_fn = &AudioChunkCache::seekFn;
+    info->size_fn = &AudioChunkCache::sizeFn;
+    info->close_fn = &AudioChunkCache::closeFn;
+    info->cancel_fn = &AudioChunkCache::cancelFn;
+    return 0;
+}
+
+int64_t AudioChunkCache::readFn(void *cookie, char *buf, uint64_t nbytes)
+{
+    Stream *s = static_cast<Stream *>(cookie);
+    AudioChunkCache *self = s->cache;
+
+    QMutexLocker lock(&self->m_mutex);
+    const Track &t0 = self->m_tracks[s->songId];
+    if (t0.size >= 0 && s->pos >= t0.size) return 0;
+
+    qint64 chunk = s->pos / kChunkSize;
+    if (!self->waitForChunkLocked(s, chunk)) return -1;
+
+    // 等待期间哈希表可能变化，重新取
+    const Track &t = self->m_tracks[s->songId];
+    const QByteArray &data = t.chunks.value(chunk);
+    qint64 offset = s->pos - chunk * kChunkSize;
+    qint64 n = qMin<qint64>(qint64(nbytes), data.size() - offset);
+    if (n <= 0) return 0;
+    memcpy(buf, data.constData() + offset, size_t(n));
+    s->pos += n;
+    return n;
+}
+
+int64_t AudioChunkCache::seekFn(void *cookie, int64_t offset)
+{
+    Stream *s = static_cast<Stream *>(cookie);
+    QMutexLocker lock(&s->cache->m_mutex);
+    qint64 size = s->cache->m_tracks[s->songId].size;
+    if (offset < 0 || (size >= 0 && offset > size)) return MPV_ERROR_GENERIC;
+    s->pos = offset;
+    return offset;
+}
+
+int64_t AudioChunkCache::sizeFn(void *cookie)
+{
+    Stream *s = static_cast<Stream *>(cookie);
+    QMutexLocker lock(&s->cache->m_mutex);
+    qint64 size = s->cache->m_tracks[s->songId].size;
+    return size >= 0 ? size : MPV_ERROR_UNSUPPORTED;
+}
+
+void AudioChunkCache::closeFn(void *cookie)
+{
+    Stream *s = static_cast<Stream *>(cookie);
+    {
+        QMutexLocker lock(&s->cache->m_mutex);
+        if (--s->cache->m_tracks[s->songId].openCount == 0) s->cache->mergeDuplicatesLocked();
+    }
+    delete s;
+}
+
+void AudioChunkCache::cancelFn(void *cookie)
+{
+    Stream *s = static_cast<Stream *>(cookie);
+    QMutexLocker lock(&s->cache->m_mutex);
+    s->cancelled = true;
+    s->cache->m_cond.wakeAll();
+}
+
+/*-------------------------------
+ * 等待分块就绪；顺带预取后面几块。
+ * 返回 false 表示失败/取消/超时
+ *------------------------------*/
+bool AudioChunkCache::waitForChunkLocked(Stream *s, qint64 chunk)
+{
+    {
+        Track &t = m_tracks[s->songId];
+        t.lastUse = ++m_useCounter;
+        requestChunkLocked(s->songId, t, chunk);
+        for (int i = 1; i <= kReadaheadChunks; ++i) {
+            qint64 next = chunk + i;
+            if (t.size >= 0 && next * kChunkSize >= t.size) break;
+            requestChunkLocked(s->songId, t, next);
+        }
+    }
+
+    // 期限只算一次：其他分块到达也会唤醒，不能每次都重新计时
+    QDeadlineTimer deadline(kReadTimeoutMs);
+    while (true) {
+        Track &t = m_tracks[s->songId];
+        if (t.chunks.contains(chunk)) return true;
+        if (s->cancelled) return false;
+        if (t.failed.remove(chunk)) return false;
+        if (!m_cond.wait(&m_mutex, deadline)) {
+            qWarning() << "chunk read timed out" << s->songId << chunk;
+            return false;
+        }
+    }
+}
+
+void AudioChunkCache::requestChunkLocked(int songId, Track &t, qint64 chunk)
+{
+    if (t.chunks.contains(chunk) || t.inflight.contains(chunk) || t.url.isEmpty()) return;
+    // 重新请求：之前的失败（多半是没人等的预取）不能让这次读取直接报错
+    t.failed.remove(chunk);
+    if (t.refreshing) {
+        t.stalled.insert(chunk);
+        return;
+    }
+    t.inflight.insert(chunk);
+    // 不支持 Range 的服务器：正在下载的整个文件已经包含这一块，不再另发请求
+    if (t.noRange && t.inflight.size() > 1) return;
+    QString url = t.url;
+    // QNetworkAccessManager 只能在它所在的线程（网络模块的 I/O 线程）使用
+    QMetaObject::invokeMethod(m_net, [this, songId, chunk, url]() {
+        startFetch(songId, chunk, url);
+    }, Qt::QueuedConnection);
+}
+
+void AudioChunkCache::startFetch(int songId, qint64 chunk, const QString &url)
+{
+    {
+        // 排队期间可能已被整个文件的响应填上
+        QMutexLocker lock(&m_mutex);
+        Track &t = m_tracks[songId];
+        if (t.chunks.contains(chunk) || !t.inflight.contains(chunk)) return;
+    }
+    QNetworkRequest req(url);
+    req.setRawHeader("User-Agent", "QtMusicPlayer/1.0");
+    qint64 from = chunk * kChunkSize;
+    req.setRawHeader("Range", QString("bytes=%1-%2").arg(from).arg(from + kChunkSize - 1).toLatin1());
+    QNetworkReply *reply = m_net->getRaw(req);
+    {
+        QMutexLocker lock(&m_mutex);
+        m_tracks[songId].replies.insert(chunk, reply);
+    }
+    // 完成处理也留在 I/O 线程：只动加锁保护的分块数据，不必绕回界面线程
+    connect(reply, &QNetworkReply::finished, m_net, [this, reply, songId, chunk]() {
+        onFetchFinished(reply, songId, chunk);
+    });
+}
+
+void AudioChunkCache::onFetchFinished(QNetworkReply *reply, int songId, qint64 chunk)
+{
+    reply->deleteLater();
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    QByteArray body = reply->readAll();
+
+    QMutexLocker lock(&m_mutex);
+    Track &t = m_tracks[songId];
+    t.replies.remove(chunk);
+    t.inflight.remove(chunk);
+    // 已被整个文件的响应填上，或者本身就是因此取消的预取
+    if (t.chunks.contains(chunk) || reply->error() == QNetworkReply::OperationCanceledError) return;
+
+    if (status == 403 || status == 410) {
+        // 带签名的地址过期了：分块先挂起，换到新地址后再下载，读取方继续等
+        if (QUrl(t.url) != reply->request().url()) {
+            // 已经换过地址，只是旧地址上的请求才回来
+            requestChunkLocked(songId, t, chunk);
+            return;
+        }
+        t.stalled.insert(chunk);
+        if (t.noRange) {
+            // 等这个整文件请求的分块一起挂起
+            t.stalled += t.inflight;
+            t.inflight.clear();
+        }
+        if (!t.refreshing) {
+            t.refreshing = true;
+            lock.unlock();
+            emit sourceExpired(songId);
+        }
+        return;
+    }
+    if (reply->error() != QNetworkReply::NoError || (status != 206 && status != 200)) {
+        qWarning() << "chunk fetch failed" << songId << chunk << reply->errorString();
+        t.failed.insert(chunk);
+        if (t.noRange) {
+            t.failed += t.inflight;
+            t.inflight.clear();
+        }
+    } else if (status == 200) {
+        // 服务器不支持 Range，拿到的是整个文件：全部切块存下，
+        // 同时发出的预取拿到的也是整个文件，全部取消；之后这首只保留一个请求
+        t.noRange = true;
+        t.size = body.size();
+        for (qint64 off = 0, i = 0; off < body.size(); off += kChunkSize, ++i) {
+            if (!t.chunks.contains(i)) storeChunkLocked(t, i, body.mid(int(off), int(kChunkSize)));
+        }
+        const QList<QNetworkReply *> siblings = t.replies.values();
+        t.replies.clear();
+        t.inflight.clear();
+        evictLocked(songId);
+        mergeDuplicatesLocked();
+        m_cond.wakeAll();
+        // abort 会同步发出 finished，回调里要加锁，先解锁
+        lock.unlock();
+        for (QNetworkReply *r : siblings) r->abort();
+        return;
+    } else {
+        // Content-Range: bytes a-b/total
+        static const QRegularExpression rx("/(\\d+)");
+        QRegularExpressionMatch m = rx.match(QString::fromLatin1(reply->rawHeader("Content-Range")));
+        if (m.hasMatch()) t.size = m.captured(1).toLongLong();
+        if (!t.chunks.contains(chunk)) storeChunkLocked(t, chunk, body);
+    }
+
+    evictLocked(songId);
+    mergeDuplicatesLocked();
+    m_cond.wakeAll();
+}
+
+void AudioChunkCache::storeChunkLocked(Track &t, qint64 chunk, const QByteArray &data)
+{
+    t.chunks.insert(chunk, data);
+    m_totalBytes += data.size();
+}
+
+/*-------------------------------
+ * 合并待确认的重复歌曲。声纹相同只说明是同一录音，码率、封装可能不同，
+ * 所以要两边都知道大小且首块逐字节相同才合并；被合并的一方不能有打开中的流
+ * 或在途的下载（它们按原 id 访问分块）。不同的文件记一次结果后不再比较
+ *------------------------------*/
+void AudioChunkCache::mergeDuplicatesLocked()
+{
+    for (auto it = m_pendingDuplicates.begin(); it != m_pendingDuplicates.end(); ) {
+        int songId = it.key();
+        int canonical = keyLocked(it.value());
+        auto from = m_tracks.find(songId);
+        auto to = m_tracks.find(canonical);
+        if (from == m_tracks.end() || to == m_tracks.end() || from->size < 0 || to->size < 0
+            || !from->chunks.contains(0) || !to->chunks.contains(0)) {
+            ++it;
+            continue;
+        }
+        if (from->size != to->size || from->chunks.value(0) != to->chunks.value(0)) {
+            it = m_pendingDuplicates.erase(it);
+            continue;
+        }
+        if (from->openCount > 0 || !from->inflight.isEmpty()) {
+            ++it;
+            continue;
+        }
+
+        for (auto c = from->chunks.constBegin(); c != from->chunks.constEnd(); ++c) {
+            if (to->chunks.contains(c.key())) {
+                m_totalBytes -= c->size();
+            } else {
+                to->chunks.insert(c.key(), c.value());
+            }
+        }
+        if (to->url.isEmpty()) to->url = from->url;
+        to->lastUse = qMax(to->lastUse, from->lastUse);
+        m_tracks.erase(from);
+        m_aliases.insert(songId, canonical);
+        it = m_pendingDuplicates.erase(it);
+    }
+}
+
+// 超过上限时按最久未用淘汰整首，正在播放（打开中）的不动
+void AudioChunkCache::evictLocked(int keepSongId)
+{
+    while (m_totalBytes > kMaxCacheBytes) {
+        auto victim = m_tracks.end();
+        for (auto it = m_tracks.begin(); it != m_tracks.end(); ++it) {
+            if (it.key() == keepSongId || it->openCount > 0 || it->chunks.isEmpty()) continue;
+            if (victim == m_tracks.end() || it->lastUse < victim->lastUse) victim = it;
+        }
+        if (victim == m_tracks.end()) return;
+        for (const QByteArray &c : victim->chunks) m_totalBytes -= c.size();
+        victim->chunks.clear();
+        victim->size = -1;
+    }
+}
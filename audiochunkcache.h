@@ -0,0 +1,98 @@
+/**
+ * @brief   : 稀疏分块音频缓存，通过 mpv stream_cb 协议（mcache://）给 mpv 提供数据，
+ *            缺失的分块用 HTTP Range 请求补齐，重播/回拖/单曲循环不再重复下载
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#ifndef AUDIOCHUNKCACHE_H
+#define AUDIOCHUNKCACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QByteArray>
+#include <mpv/client.h>
+#include <mpv/stream_cb.h>
+
+class NetworkManager;
+class QNetworkReply;
+
+class AudioChunkCache : public QObject
+{
+    Q_OBJECT
+public:
+    // 下载回调在 net 的 I/O 线程里访问本对象，net 须先于本对象析构（结束线程）
+    explicit AudioChunkCache(NetworkManager *net, QObject *parent = nullptr);
+
+    static QString streamUrl(int songId);          // mcache://<歌曲 id>
+    void registerWith(mpv_handle *mpv);            // 在 mpv 内核上注册 mcache 协议
+
+    // 设置/刷新歌曲的真实地址（地址过期后换新地址，已缓存的分块继续有效）
+    void setSource(int songId, const QString &url);
+
+    // 声纹判定为同一录音：确认两份文件逐字节相同（大小一致、首块相同）后共用分块，
+    // 此前以及不同编码的版本各缓存各的
+    void setDuplicate(int songId, int canonicalId);
+
+    qint64 cachedBytes() const;
+
+signals:
+    // 地址过期（服务器返回 403/410）：持有者重新解析后调用 setSource，
+    // 等待中的分块随之用新地址重新下载。在网络模块的 I/O 线程发出
+    void sourceExpired(int songId);
+
+private:
+    struct Track {
+        QString url;
+        qint64 size = -1;                 // 文件总大小，-1 表示还不知道
+        QHash<qint64, QByteArray> chunks; // 分块序号 -> 数据（稀疏）
+        QSet<qint64> inflight;            // 正在下载的分块
+        QHash<qint64, QNetworkReply *> replies; // 已发出的请求（I/O 线程），用于取消
+        bool noRange = false;             // 服务器忽略 Range，每次返回整个文件
+        QSet<qint64> failed;              // 下载失败，等读取方取走错误
+        QSet<qint64> stalled;             // 地址过期，等新地址再下载
+        bool refreshing = false;          // 已发出 sourceExpired，还没拿到新地址
+        int openCount = 0;                // 打开中的流，大于 0 时不淘汰
+        quint64 lastUse = 0;
+    };
+
+    struct Stream {
+        AudioChunkCache *cache;
+        int songId;
+        qint64 pos;
+        bool cancelled;
+    };
+
+    // mpv stream_cb 回调（mpv 的读取线程，允许阻塞）
+    static int openFn(void *userData, char *uri, mpv_stream_cb_info *info);
+    static int64_t readFn(void *cookie, char *buf, uint64_t nbytes);
+    static int64_t seekFn(void *cookie, int64_t offset);
+    static int64_t sizeFn(void *cookie);
+    static void closeFn(void *cookie);
+    static void cancelFn(void *cookie);
+
+    // 以下 *Locked 函数要求已持有 m_mutex
+    bool waitForChunkLocked(Stream *s, qint64 chunk);
+    void requestChunkLocked(int songId, Track &t, qint64 chunk);
+    void evictLocked(int keepSongId);
+
+    // 以下两个在网络模块的 I/O 线程执行
+    void startFetch(int songId, qint64 chunk, const QString &url);
+    void onFetchFinished(QNetworkReply *reply, int songId, qint64 chunk);
+    void storeChunkLocked(Track &t, qint64 chunk, const QByteArray &data);
+    int keyLocked(int songId) const { return m_aliases.value(songId, songId); }
+    void mergeDuplicatesLocked();
+
+    NetworkManager *m_net;
+    mutable QMutex m_mutex;
+    QWaitCondition m_cond;
+    QHash<int, Track> m_tracks;
+    QHash<int, int> m_pendingDuplicates; // 待确认的重复：歌曲 id -> 代表 id
+    QHash<int, int> m_aliases;           // 已合并：歌曲 id -> 实际存放分块的 id
+    qint64 m_totalBytes;
+    quint64 m_useCounter;
+};
+
+#endif // AUDIOCHUNKCACHE_H
@@ -0,0 +1,302 @@
+/**
+ * @brief   : 独立音频进程实现
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#include "audioengine.h"
+#include "audiochunkcache.h"
+#include "loudnessscanner.h"
+#include "mpvplayer.h"
+#include "waveformgenerator.h"
+#include <QCoreApplication>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QDebug>
+#include <cstring>
+
+// 播放中发布位置的间隔（毫秒），与界面帧率一致
+static const int kStatusIntervalMs = 16;
+// 没有界面连接且不在播放超过该时长（毫秒）后引擎自行退出
+static const int kIdleExitMs = 5 * 60 * 1000;
+
+AudioEngine::AudioEngine(const QString &serverName, QObject *parent)
+    : QObject(parent),
+      m_serverName(serverName),
+      m_server(new QLocalServer(this)),
+      m_client(nullptr),
+      m_status(engineStatusKey(serverName)),
+      m_net(new NetworkManager),
+      m_chunkCache(new AudioChunkCache(m_net, this)),
+      m_player(new MPVPlayer(this))
+{
+    m_player->setChunkCache(m_chunkCache);
+
+    connect(m_server, &QLocalServer::newConnection, this, &AudioEngine::onNewConnection);
+    connect(m_net, &NetworkManager::getUrlFinished, this, &AudioEngine::onGetUrlFinished);
+    // 地址过期不必经过界面，引擎直接换新地址
+    connect(m_chunkCache, &AudioChunkCache::sourceExpired, this, [this](int songId) {
+        m_refreshIds.insert(songId);
+        m_net->getUrlById(songId);
+    });
+
+    m_statusTimer.setInterval(kStatusIntervalMs);
+    connect(&m_statusTimer, &QTimer::timeout, this, &AudioEngine::publishStatus);
+
+    // 界面正常退出只断开连接；没人控制且停下来后不再常驻
+    m_idleTimer.setSingleShot(true);
+    m_idleTimer.setInterval(kIdleExitMs);
+    connect(&m_idleTimer, &QTimer::timeout, this, [this]() {
+        if (m_client || m_player->isPlaying()) return;
+        m_player->stop();
+        QCoreApplication::quit();
+    });
+    // 界面只在播放时轮询共享内存；暂停/停止时的变化（seek、加载）用事件通知
+    connect(m_player, &MPVPlayer::positionChanged, this, [this]() {
+        publishStatus();
+        if (!m_player->isPlaying()) send(EvtStatusChanged);
+    });
+    connect(m_player, &MPVPlayer::durationChanged, this, [this]() {
+        publishStatus();
+        if (!m_player->isPlaying()) send(EvtStatusChanged);
+    });
+    connect(m_player, &MPVPlayer::stateChanged, this, [this](bool playing) {
+        if (playing) m_statusTimer.start();
+        else m_statusTimer.stop();
+        publishStatus();
+        send(EvtStatusChanged);
+        updateIdleTimer();
+    });
+
+    // 播放器信号转成事件发给界面
+    connect(m_player, &MPVPlayer::playbackFinished, this, [this]() { send(EvtPlaybackFinished); });
+    connect(m_player, &MPVPlayer::trackAdvanced, this, [this]() { send(EvtTrackAdvanced); });
+    connect(m_player, &MPVPlayer::streamFailed, this, [this](qint64 resumeMs, bool stalled) {
+        send(EvtStreamFailed, QVariantList() << resumeMs << stalled);
+    });
+    connect(m_player, &MPVPlayer::songUrlRequested, this, &AudioEngine::onSongUrlRequested);
+    connect(m_player, &MPVPlayer::bufferedRangesChanged, this, [this](const QVector<BufferedRange> &ranges) {
+        QVariantList args;
+        for (const BufferedRange &r : ranges) args << r.startMs << r.endMs;
+        send(EvtBufferedRanges, args);
+    });
+    connect(m_player, &MPVPlayer::audioDevicesChanged, this, [this](const QList<MpvAudioDevice> &devices) {
+        QVariantList args;
+        for (const MpvAudioDevice &d : devices) args << d.name << d.description;
+        send(EvtAudioDevices, args);
+    });
+    connect(m_player, &MPVPlayer::firstAudio, this, [this](qint64 ms) {
+        send(EvtFirstAudio, QVariantList() << ms);
+    });
+    connect(m_player, &MPVPlayer::seekCompleted, this, [this](qint64 ms, bool exact) {
+        send(EvtSeekCompleted, QVariantList() << ms << exact);
+    });
+    connect(m_player, &MPVPlayer::seekWillStall, this, [this](qint64 targetMs, qint64 stallMs) {
+        send(EvtSeekWillStall, QVariantList() << targetMs << stallMs);
+    });
+    connect(m_player, &MPVPlayer::outputLatencyMeasured, this, [this](qint64 ms) {
+        send(EvtOutputLatency, QVariantList() << ms);
+    });
+    connect(m_player, &MPVPlayer::levelsChanged, this, [this](const AudioLevels &levels) {
+        send(EvtLevels, levels.toVariant());
+    });
+    connect(m_player, &MPVPlayer::requestFailed, this, [this](quint64 id, int err, const QString &msg) {
+        send(EvtRequestFailed, QVariantList() << id << err << msg);
+    });
+}
+
+AudioEngine::~AudioEngine()
+{
+    // 先停播放器，再结束网络线程（下载回调会访问分块缓存），缓存最后析构
+    delete m_player;
+    delete m_net;
+}
+
+bool AudioEngine::start()
+{
+    // 已有引擎在服务这个名称（两个界面同时拉起）时让位
+    QLocalSocket probe;
+    probe.connectToServer(m_serverName);
+    if (probe.waitForConnected(200)) {
+        qWarning() << "audio engine already running:" << m_serverName;
+        return false;
+    }
+
+    // 上一个引擎崩溃时可能留下共享内存，直接复用
+    if (!m_status.create(sizeof(EngineStatusRing)) && !m_status.attach()) {
+        qWarning() << "audio engine shared memory failed:" << m_status.errorString();
+        return false;
+    }
+    m_status.lock();
+    memset(m_status.data(), 0, sizeof(EngineStatusRing));
+    static_cast<EngineStatusRing *>(m_status.data())->magic = kEngineStatusMagic;
+    m_status.unlock();
+    publishStatus();
+
+    QLocalServer::removeServer(m_serverName);
+    if (!m_server->listen(m_serverName)) {
+        qWarning() << "audio engine listen failed:" << m_server->errorString();
+        return false;
+    }
+    // 拉起它的界面随后就会连上；万一没连上，空闲到时退出
+    updateIdleTimer();
+    return true;
+}
+
+void AudioEngine::onNewConnection()
+{
+    QLocalSocket *socket = m_server->nextPendingConnection();
+    if (!socket) return;
+
+    // 新界面取代旧连接（旧界面多半已经崩溃）
+    if (m_client) {
+        m_client->disconnect(this);
+        m_client->abort();
+        m_client->deleteLater();
+    }
+    m_client = socket;
+    connect(m_client, &QLocalSocket::readyRead, this, &AudioEngine::onReadyRead);
+    connect(m_client, &QLocalSocket::disconnected, this, &AudioEngine::onClientDisconnected);
+
+    updateIdleTimer();
+    sendSnapshot();
+    // 断开期间转发出去的地址请求不会再有回复，重新发给新界面
+    const QSet<int> pending = m_forwardedIds;
+    for (int id : pending) send(EvtSongUrlRequested, QVariantList() << id);
+}
+
+void AudioEngine::onClientDisconnected()
+{
+    if (!m_client) return;
+    m_client->deleteLater();
+    m_client = nullptr;
+
+    // 界面不在了，继续播放；等待界面解析的地址改由引擎自己解析
+    const QSet<int> pending = m_forwardedIds;
+    m_forwardedIds.clear();
+    for (int id : pending) resolveLocally(id);
+    updateIdleTimer();
+}
+
+void AudioEngine::updateIdleTimer()
+{
+    if (m_client || m_player->isPlaying()) m_idleTimer.stop();
+    else if (!m_idleTimer.isActive()) m_idleTimer.start();
+}
+
+void AudioEngine::onReadyRead()
+{
+    QDataStream in(m_client);
+    in.setVersion(kEngineStreamVersion);
+
+    forever {
+        in.startTransaction();
+        quint8 type = 0;
+        QVariantList args;
+        in >> type >> args;
+        if (!in.commitTransaction()) break;
+        handleCommand(type, args);
+        if (!m_client) break;
+    }
+}
+
+void AudioEngine::handleCommand(int type, const QVariantList &args)
+{
+    auto arg = [&args](int i) { return i < args.size() ? args.at(i) : QVariant(); };
+
+    switch (type) {
+    case CmdPlaySong:       m_player->playSong(arg(0).toInt(), arg(1).toLongLong()); break;
+    case CmdQueueNextSong:  m_player->queueNextSong(arg(0).toInt()); break;
+    case CmdProvideSongUrl: {
+        m_forwardedIds.remove(arg(0).toInt());
+        TrackTrim trim;
+        trim.startMs = arg(3).toLongLong();
+        trim.endMs = arg(4).toLongLong();
+        m_player->provideSongUrl(arg(0).toInt(), arg(1).toString(), arg(2).toDouble(), trim);
+        break;
+    }
+    case CmdClearQueue:     m_player->clearQueue(); break;
+    case CmdPlay:           m_player->play(); break;
+    case CmdPause:          m_player->pause(); break;
+    case CmdStop:           m_player->stop(); break;
+    case CmdSetVolume:      m_player->setVolume(arg(0).toInt()); break;
+    case CmdSetPosition:    m_player->setPosition(arg(0).toLongLong()); break;
+    case CmdSetCrossfade:   m_player->setCrossfade(arg(0).toDouble()); break;
+    case CmdBeginScrub:     m_player->beginScrub(); break;
+    case CmdScrubTo:        m_player->scrubTo(arg(0).toLongLong()); break;
+    case CmdEndScrub:       m_player->endScrub(arg(0).toLongLong()); break;
+    case CmdSetAudioDevice: m_player->setAudioDevice(arg(0).toString()); break;
+    case CmdSetLowLatency:  m_player->setLowLatency(arg(0).toBool()); break;
+    case CmdSetDsp:         m_player->setDsp(DspSettings::fromVariant(arg(0).toMap())); break;
+    case CmdSetMetering:    m_player->setMetering(arg(0).toBool()); break;
+    case CmdSetSpeed:       m_player->setSpeed(arg(0).toDouble()); break;
+    case CmdShutdown:
+        m_player->stop();
+        QCoreApplication::quit();
+        break;
+    default:
+        qWarning() << "audio engine: unknown command" << type;
+        break;
+    }
+}
+
+void AudioEngine::send(int type, const QVariantList &args)
+{
+    if (!m_client || m_client->state() != QLocalSocket::ConnectedState) return;
+
+    QDataStream out(m_client);
+    out.setVersion(kEngineStreamVersion);
+    out << quint8(type) << args;
+}
+
+void AudioEngine::sendSnapshot()
+{
+    QVariantList ranges;
+    for (const BufferedRange &r : m_player->bufferedRanges()) ranges << r.startMs << r.endMs;
+    send(EvtBufferedRanges, ranges);
+
+    QVariantList devices;
+    for (const MpvAudioDevice &d : m_player->audioDevices()) devices << d.name << d.description;
+    send(EvtAudioDevices, devices);
+
+    publishStatus();
+    send(EvtStatusChanged);
+}
+
+void AudioEngine::onSongUrlRequested(int songId)
+{
+    if (m_client) {
+        // 界面解析时顺带拿到歌词等元信息
+        m_forwardedIds.insert(songId);
+        send(EvtSongUrlRequested, QVariantList() << songId);
+    } else {
+        resolveLocally(songId);
+    }
+}
+
+void AudioEngine::resolveLocally(int songId)
+{
+    m_localIds.insert(songId);
+    m_net->getUrlById(songId);
+}
+
+void AudioEngine::onGetUrlFinished(const NetworkManager::UrlResult &res)
+{
+    if (m_refreshIds.remove(res.id)) {
+        m_chunkCache->setSource(res.id, res.url);
+        return;
+    }
+    if (!m_localIds.remove(res.id)) return;
+    // 没有界面时自己解析地址，归一化增益和静音裁剪直接读分析结果
+    m_player->provideSongUrl(res.id, res.url, LoudnessScanner::gainDb(res.id), WaveformGenerator::trim(res.id));
+}
+
+void AudioEngine::publishStatus()
+{
+    if (!m_status.isAttached()) return;
+
+    EngineStatus status;
+    status.positionMs = m_player->positionMs();
+    status.durationMs = m_player->durationMs();
+    status.playing = m_player->isPlaying();
+    publishEngineStatus(static_cast<EngineStatusRing *>(m_status.data()), status);
+}
@@ -0,0 +1,62 @@
+/**
+ * @brief   : 独立音频进程：在子进程里运行 MPVPlayer，命令经本地套接字下发，
+ *            位置/时长/状态写入共享内存；界面卡死或崩溃不影响出声，界面重启后重新连接
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#ifndef AUDIOENGINE_H
+#define AUDIOENGINE_H
+
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+#include <QVariantList>
+#include <QSharedMemory>
+#include "engineprotocol.h"
+#include "networkmanager.h"
+
+class QLocalServer;
+class QLocalSocket;
+class MPVPlayer;
+class AudioChunkCache;
+
+class AudioEngine : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AudioEngine(const QString &serverName, QObject *parent = nullptr);
+    ~AudioEngine();
+
+    // 开始监听；同名引擎已在运行时返回 false（调用方直接退出）
+    bool start();
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onClientDisconnected();
+    void onSongUrlRequested(int songId);
+    void onGetUrlFinished(const NetworkManager::UrlResult &res);
+    void publishStatus();
+    void updateIdleTimer();
+
+private:
+    void handleCommand(int type, const QVariantList &args);
+    void send(int type, const QVariantList &args = QVariantList());
+    void sendSnapshot();
+    void resolveLocally(int songId);
+
+    QString m_serverName;
+    QLocalServer *m_server;
+    QLocalSocket *m_client;      // 同一时间只服务一个界面，新连接取代旧连接
+    QSharedMemory m_status;
+    NetworkManager *m_net;
+    AudioChunkCache *m_chunkCache;
+    MPVPlayer *m_player;
+    QTimer m_statusTimer;        // 播放中按帧率发布位置
+    QTimer m_idleTimer;          // 没有界面且不在播放时运行，到时引擎退出
+    QSet<int> m_forwardedIds;    // 已交给界面解析、还没回复的歌曲
+    QSet<int> m_localIds;        // 没有界面时由引擎自己解析的歌曲
+    QSet<int> m_refreshIds;      // 分块缓存里地址过期、正在重新解析的歌曲
+};
+
+#endif // AUDIOENGINE_H
@@ -0,0 +1,206 @@
+/**
+ * @brief   : 播放器接口：进程内的 MPVPlayer 和独立音频进程的 RemotePlayer 共用，
+ *            主窗口只依赖这里的命令和信号
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#ifndef AUDIOPLAYER_H
+#define AUDIOPLAYER_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QList>
+#include <QVariantMap>
+#include "mpveventchannel.h"
+
+enum PlayMode {
+    PlaySequence,   // 顺序播放
+    PlayRandom,     // 随机播放
+    PlaySingleLoop, // 单曲循环
+    PlayCrossfade   // 顺序播放 + 淡入淡出衔接
+};
+
+// 已缓存的时间区间（毫秒），seek 到区间内不需要网络
+struct BufferedRange {
+    qint64 startMs;
+    qint64 endMs;
+    bool operator==(const BufferedRange &o) const { return startMs == o.startMs && endMs == o.endMs; }
+};
+
+// 首尾静音裁剪点（毫秒），0 表示该端不裁剪
+struct TrackTrim {
+    qint64 startMs = 0;
+    qint64 endMs = 0;
+    bool isNull() const { return startMs <= 0 && endMs <= 0; }
+};
+
+// 均衡器频段（ISO 倍频程中心频率，Hz）
+static const int kEqBandCount = 10;
+static const double kEqBandFreqs[kEqBandCount] = {31, 62, 125, 250, 500, 1000, 2000, 4000, 8000, 16000};
+
+/*
+ * DSP 链参数：均衡器 -> 压缩器 -> 限幅器，增益/阈值单位 dB。
+ * 只有总开关变化时重建滤镜链，其余参数通过 af-command 实时修改。
+ */
+struct DspSettings {
+    bool enabled = false;
+    QVector<double> eqGainsDb = QVector<double>(kEqBandCount, 0.0);
+
+    bool compressorEnabled = false;
+    double compThresholdDb = -18.0;
+    double compRatio = 3.0;
+    double compAttackMs = 20.0;
+    double compReleaseMs = 250.0;
+    double compMakeupDb = 0.0;
+
+    bool limiterEnabled = true;
+    double limiterCeilingDb = -1.0;
+
+    // 预设保存（settings.ini）和跨进程传输共用
+    QVariantMap toVariant() const
+    {
+        QVariantMap m;
+        m["enabled"] = enabled;
+        QVariantList gains;
+        for (double g : eqGainsDb) gains << g;
+        m["eq"] = gains;
+        m["comp"] = compressorEnabled;
+        m["compThreshold"] = compThresholdDb;
+        m["compRatio"] = compRatio;
+        m["compAttack"] = compAttackMs;
+        m["compRelease"] = compReleaseMs;
+        m["compMakeup"] = compMakeupDb;
+        m["limiter"] = limiterEnabled;
+        m["limiterCeiling"] = limiterCeilingDb;
+        return m;
+    }
+
+    static DspSettings fromVariant(const QVariantMap &m)
+    {
+        DspSettings d;
+        d.enabled = m.value("enabled", d.enabled).toBool();
+        const QVariantList gains = m.value("eq").toList();
+        for (int i = 0; i < gains.size() && i < kEqBandCount; ++i) d.eqGainsDb[i] = gains.at(i).toDouble();
+        d.compressorEnabled = m.value("comp", d.compressorEnabled).toBool();
+        d.compThresholdDb = m.value("compThreshold", d.compThresholdDb).toDouble();
+        d.compRatio = m.value("compRatio", d.compRatio).toDouble();
+        d.compAttackMs = m.value("compAttack", d.compAttackMs).toDouble();
+        d.compReleaseMs = m.value("compRelease", d.compReleaseMs).toDouble();
+        d.compMakeupDb = m.value("compMakeup", d.compMakeupDb).toDouble();
+        d.limiterEnabled = m.value("limiter", d.limiterEnabled).toBool();
+        d.limiterCeilingDb = m.value("limiterCeiling", d.limiterCeilingDb).toDouble();
+        return d;
+    }
+};
+
+// 电平表粗分频段的中心频率（Hz），相邻约 1.3 倍频程
+static const int kMeterBandCount = 6;
+static const double kMeterBandFreqs[kMeterBandCount] = {63, 160, 400, 1000, 2500, 6300};
+// 电平下限（dBFS），静音时 astats 报 -inf
+static const double kMeterFloorDb = -90.0;
+
+/*
+ * 一次电平表刷新：左右声道 RMS/峰值、各频段 RMS，以及整体频谱特征。
+ * 由播放器按固定频率发出，界面直接绘制，不再做计算。
+ */
+struct AudioLevels {
+    QVector<double> rmsDb;    // 每声道 RMS（dBFS）
+    QVector<double> peakDb;   // 每声道峰值（dBFS）
+    QVector<double> bandsDb;  // kMeterBandFreqs 各频段 RMS（dBFS）
+    double centroidHz = 0.0;  // 频谱质心
+    double flatness = 0.0;    // 频谱平坦度，0 为纯音，1 为白噪声
+
+    // 跨进程传输用
+    QVariantList toVariant() const
+    {
+        QVariantList v;
+        QVariantList rms, peak, bands;
+        for (double x : rmsDb) rms << x;
+        for (double x : peakDb) peak << x;
+        for (double x : bandsDb) bands << x;
+        v << QVariant(rms) << QVariant(peak) << QVariant(bands) << centroidHz << flatness;
+        return v;
+    }
+
+    static AudioLevels fromVariant(const QVariantList &v)
+    {
+        AudioLevels l;
+        for (const QVariant &x : v.value(0).toList()) l.rmsDb << x.toDouble();
+        for (const QVariant &x : v.value(1).toList()) l.peakDb << x.toDouble();
+        for (const QVariant &x : v.value(2).toList()) l.bandsDb << x.toDouble();
+        l.centroidHz = v.value(3).toDouble();
+        l.flatness = v.value(4).toDouble();
+        return l;
+    }
+};
+
+class AudioPlayer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AudioPlayer(QObject *parent = nullptr) : QObject(parent) {}
+    virtual ~AudioPlayer() {}
+
+    // 命令全部异步；返回的请求 id 只在进程内播放时有意义（远程时为 0）
+    virtual quint64 playSong(int songId, qint64 startMs = -1) = 0;
+    virtual quint64 queueNextSong(int songId) = 0;
+    // gainDb：响度归一化增益；trim：跳过首尾静音。都随地址一起在该曲目加载时生效，只作用于这一首
+    virtual void provideSongUrl(int songId, const QString &url, double gainDb = 0.0,
+                                const TrackTrim &trim = TrackTrim()) = 0;
+    virtual void clearQueue() = 0;
+    virtual quint64 play() = 0;
+    virtual quint64 pause() = 0;
+    virtual quint64 stop() = 0;
+    virtual quint64 setVolume(int vol) = 0;
+    virtual quint64 setPosition(qint64 ms) = 0;
+    // 播放速度（1.0 为原速），多机同步时用微小的变速追赶/等待主机
+    virtual void setSpeed(double speed) = 0;
+    virtual void setCrossfade(double seconds) = 0;
+    virtual void beginScrub() = 0;
+    virtual void scrubTo(qint64 ms) = 0;
+    virtual void endScrub(qint64 ms) = 0;
+
+    virtual QVector<BufferedRange> bufferedRanges() const = 0;
+    virtual QList<MpvAudioDevice> audioDevices() const = 0;
+    virtual QString audioDevice() const = 0;
+    virtual void setAudioDevice(const QString &name) = 0;
+    virtual void setLowLatency(bool enabled) = 0;
+    virtual bool isLowLatency() const = 0;
+
+    // DSP：总开关变化时重建 af 滤镜链，其余参数只发 af-command，不中断声音
+    virtual void setDsp(const DspSettings &dsp) = 0;
+    virtual DspSettings dsp() const = 0;
+
+    // 电平表：打开时在 af 链末尾插入测量滤镜并按固定频率发出 levelsChanged，关闭时完全移除
+    virtual void setMetering(bool enabled) = 0;
+    virtual bool isMetering() const = 0;
+
+    virtual bool isPlaying() const = 0;
+    // 按帧率读取的位置/时长（毫秒），不产生往返；没有曲目时位置为 -1
+    virtual qint64 positionMs() const = 0;
+    virtual qint64 durationMs() const = 0;
+
+signals:
+    void positionChanged(qint64 ms);
+    void durationChanged(qint64 ms);
+    void stateChanged(bool playing);
+    void playbackFinished();  // 播完且没有预排下一首
+    void trackAdvanced();     // 已切到预排的下一首（playlist-pos 变化或淡入淡出开始）
+
+    void seekCompleted(qint64 latencyMs, bool exact); // 从发出 seek 到恢复播放的耗时
+    void firstAudio(qint64 latencyMs);                // 从 playUrl 到开始出声的耗时
+    void bufferedRangesChanged(const QVector<BufferedRange> &ranges);
+    void seekWillStall(qint64 targetMs, qint64 expectedStallMs); // 目标未缓存；-1 表示无法估计
+    // 播放中途流出错或长时间卡在缓冲：resumeMs 为断点，调用方重新解析地址后续播
+    void streamFailed(qint64 resumeMs, bool stalled);
+    void songUrlRequested(int songId); // mpv 正在加载 music-id://，需要真实地址
+    void audioDevicesChanged(const QList<MpvAudioDevice> &devices);
+    void outputLatencyMeasured(qint64 ms); // 从 play() 到 mpv 报告的播放位置开始前进
+    void levelsChanged(const AudioLevels &levels); // 仅在电平表打开且正在播放时发出
+
+    void requestFinished(quint64 requestId);
+    void requestFailed(quint64 requestId, int mpvError, const QString &message);
+};
+
+#endif // AUDIOPLAYER_H
@@ -0,0 +1,119 @@
+/**
+ * @brief   : 节拍分析调度与缓存实现
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#include "beatanalyzer.h"
+#include "beatworker.h"
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QSettings>
+#include <QThread>
+
+// 缓存目录与文件格式：魔数、BPM、置信度、时长、拍数、第一拍位置，之后每拍一个 16 位间隔（毫秒）。
+// 算法或格式变化时换魔数，旧结果读不出来，启动后按收藏批量重扫
+static const char kCacheDir[] = "beats";
+static const quint32 kCacheMagic = 0x4D424731; // "MBG1"
+static const quint32 kMaxBeats = 100000;
+
+static QString cacheFile(int songId)
+{
+    return QString("%1/%2.bgd").arg(kCacheDir).arg(songId);
+}
+
+// 读文件头，成功时流停在第一拍之后的间隔数据开头
+static bool readHeader(QDataStream &in, quint32 &count, quint32 &firstMs, BeatGrid &grid)
+{
+    in.setVersion(QDataStream::Qt_5_6);
+    quint32 magic = 0;
+    in >> magic >> grid.bpm >> grid.confidence >> grid.durationMs >> count >> firstMs;
+    return in.status() == QDataStream::Ok && magic == kCacheMagic && count > 0 && count <= kMaxBeats;
+}
+
+BeatAnalyzer::BeatAnalyzer(AudioChunkCache *cache, QObject *parent)
+    : AnalysisQueue(cache, parent)
+{
+    QDir().mkpath(kCacheDir);
+
+    // 每个线程都有自己的 mpv 内核和临时 PCM 文件，默认只开一个（与响度扫描相同），
+    // 线程以最低优先级运行；Beats/workers 可以调大，不超过核数
+    QSettings st("settings.ini", QSettings::IniFormat);
+    int cores = qMax(1, QThread::idealThreadCount());
+    startWorkers(qBound(0, st.value("Beats/workers", 1).toInt(), cores));
+}
+
+AnalysisWorker *BeatAnalyzer::createWorker()
+{
+    return new BeatWorker(this, m_cache);
+}
+
+bool BeatAnalyzer::jobFinished(int songId, const QVariant &result)
+{
+    Q_UNUSED(result);
+    BeatGrid grid;
+    if (!load(songId, grid)) return false;
+    emit beatsReady(songId, grid);
+    return true;
+}
+
+bool BeatAnalyzer::load(int songId, BeatGrid &grid)
+{
+    QFile file(cacheFile(songId));
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    quint32 count = 0, firstMs = 0;
+    BeatGrid result;
+    if (!readHeader(in, count, firstMs, result)) return false;
+
+    result.beatsMs.reserve(int(count));
+    qint64 pos = firstMs;
+    result.beatsMs.append(pos);
+    for (quint32 i = 1; i < count; ++i) {
+        quint16 delta = 0;
+        in >> delta;
+        pos += delta;
+        result.beatsMs.append(pos);
+    }
+    if (in.status() != QDataStream::Ok) return false;
+
+    grid = result;
+    return true;
+}
+
+bool BeatAnalyzer::save(int songId, const BeatGrid &grid)
+{
+    if (grid.isEmpty()) return false;
+
+    QSaveFile file(cacheFile(songId));
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_6);
+    out << kCacheMagic << grid.bpm << grid.confidence << grid.durationMs
+        << quint32(grid.beatsMs.size()) << quint32(qMax<qint64>(0, grid.beatsMs.first()));
+    // 拍间隔远小于 65 秒，16 位足够；写入前已保证递增
+    for (int i = 1; i < grid.beatsMs.size(); ++i) {
+        qint64 delta = grid.beatsMs.at(i) - grid.beatsMs.at(i - 1);
+        out << quint16(qBound<qint64>(0, delta, 65535));
+    }
+    return file.commit();
+}
+
+bool BeatAnalyzer::isAnalyzed(int songId)
+{
+    return bpm(songId) > 0;
+}
+
+double BeatAnalyzer::bpm(int songId)
+{
+    QFile file(cacheFile(songId));
+    if (!file.open(QIODevice::ReadOnly)) return 0.0;
+    QDataStream in(&file);
+    quint32 count = 0, firstMs = 0;
+    BeatGrid header;
+    if (!readHeader(in, count, firstMs, header)) return 0.0;
+    return header.bpm;
+}
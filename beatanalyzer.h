@@ -0,0 +1,44 @@
+/**
+ * @brief   : 节拍分析：后台线程解码出 PCM，用起音检测求出 BPM 和每一拍的位置，
+ *            按歌曲 id 存成紧凑的二进制缓存，用于淡入淡出对拍和按速度筛选/排序列表
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#ifndef BEATANALYZER_H
+#define BEATANALYZER_H
+
+#include <QVector>
+#include "analysisqueue.h"
+
+struct BeatGrid {
+    double bpm = 0.0;
+    double confidence = 0.0;  // 节拍周期处的自相关与零延迟之比，节奏不明显的曲目很低
+    qint64 durationMs = 0;
+    QVector<qint64> beatsMs;  // 每一拍的位置
+    bool isEmpty() const { return bpm <= 0 || beatsMs.isEmpty(); }
+};
+
+// 分析线程数可配，收藏批量重扫时可以按核数铺开
+class BeatAnalyzer : public AnalysisQueue
+{
+    Q_OBJECT
+public:
+    // 线程数来自 settings.ini 的 Beats/workers（默认 1，不超过核数，0 表示不分析）
+    explicit BeatAnalyzer(AudioChunkCache *cache, QObject *parent = nullptr);
+
+    // 二进制缓存读写（beats/<歌曲 id>.bgd）；任何进程都可调用
+    static bool load(int songId, BeatGrid &grid);
+    static bool save(int songId, const BeatGrid &grid);
+    static bool isAnalyzed(int songId);
+    static double bpm(int songId); // 只读文件头，未分析时为 0
+
+signals:
+    void beatsReady(int songId, const BeatGrid &grid);
+
+protected:
+    AnalysisWorker *createWorker() override;
+    bool isDone(int songId) const override { return isAnalyzed(songId); }
+    bool jobFinished(int songId, const QVariant &result) override;
+};
+
+#endif // BEATANALYZER_H
@@ -0,0 +1,207 @@
+/**
+ * @brief   : 节拍分析线程实现
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#include "beatworker.h"
+#include "beatanalyzer.h"
+#include "waveformworker.h"
+#include <QTemporaryFile>
+#include <QDir>
+#include <QVector>
+#include <QtMath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define BEAT_USE_SSE
+#endif
+
+// 解码输出：节拍只看能量起伏，11 kHz 单声道足够
+static const int kSampleRate = 11025;
+// 能量包络的帧长（采样），约 11.6 ms 一帧
+static const int kHop = 128;
+// 每次从 PCM 文件读取的采样数，取 kHop 的整数倍
+static const int kReadSamples = 65536;
+// 速度搜索范围与偏好（BPM），偏好用来在半拍/双拍之间取舍
+static const double kMinBpm = 60.0;
+static const double kMaxBpm = 200.0;
+static const double kPreferredBpm = 120.0;
+static const double kTempoSpreadOctaves = 1.0;
+// 至少要有这么多个最长周期才分析（约 8 秒）
+static const int kMinPeriods = 8;
+// 对数能量的下限，避免静音段取对数后的噪声变成起音
+static const float kEnergyFloor = 1e-6f;
+// 起音强度去趋势的滑动窗口（秒）
+static const double kOnsetMeanSec = 0.5;
+// 细扫周期的范围（比例）和步长（帧）
+static const double kPeriodRefine = 0.02;
+static const double kPeriodStepFrames = 0.02;
+// 逐拍对齐时在预测位置前后搜索的范围（周期的比例）
+static const double kSnapFraction = 0.08;
+
+Q_STATIC_ASSERT(kReadSamples % kHop == 0);
+
+BeatWorker::BeatWorker(BeatAnalyzer *analyzer, AudioChunkCache *cache)
+    : AnalysisWorker(analyzer, cache)
+{
+}
+
+// 结果写进缓存文件，界面线程从文件读回
+bool BeatWorker::process(int songId, const QString &url, QVariant &result)
+{
+    Q_UNUSED(result);
+    BeatGrid grid;
+    return detect(url, grid) && BeatAnalyzer::save(songId, grid);
+}
+
+bool BeatWorker::detect(const QString &url, BeatGrid &grid)
+{
+    QTemporaryFile pcm(QDir::temp().filePath("music-beats-XXXXXX.pcm"));
+    if (!pcm.open()) return false;
+    pcm.close();
+
+    auto cancelled = [this]() { return isQuitting(); };
+    auto paused = [this]() { return isPaused(); };
+    if (!WaveformWorker::decodePcm(url, pcm.fileName(), kSampleRate, m_cache, QByteArray(), cancelled, paused))
+        return false;
+    if (!pcm.open()) return false;
+    return analyze(pcm, grid);
+}
+
+/*-------------------------------
+ * 点积内核：能量（自身点积）和自相关共用。
+ * SSE 每次处理 4 个，尾部和不支持的平台走标量循环
+ *------------------------------*/
+static float dotProduct(const float *a, const float *b, int count)
+{
+    int i = 0;
+    float sum = 0.0f;
+#ifdef BEAT_USE_SSE
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < count; ++i) sum += a[i] * b[i];
+    return sum;
+}
+
+/*-------------------------------
+ * 由能量包络求节拍：
+ * 1. 起音强度 = 对数能量的正向差分，减去滑动平均后只留突出的起音
+ * 2. 起音强度的自相关在节拍周期处有峰，加上两倍周期的支持，再按偏好速度加权
+ * 3. 抛物线插值得到小数帧的周期，再在附近细扫周期、逐帧试出相位
+ * 4. 沿网格逐拍在起音峰值上对齐，找不到峰就按周期外推
+ *------------------------------*/
+static bool detectBeats(const QVector<float> &energy, BeatGrid &grid)
+{
+    const double fps = double(kSampleRate) / kHop;
+    const int frames = energy.size();
+    const int minLag = qMax(1, int(fps * 60.0 / kMaxBpm));
+    const int maxLag = int(fps * 60.0 / kMinBpm) + 1;
+    if (frames < kMinPeriods * maxLag) return false;
+
+    QVector<float> onset(frames, 0.0f);
+    float prev = std::log10(kEnergyFloor + energy.at(0));
+    for (int n = 1; n < frames; ++n) {
+        float cur = std::log10(kEnergyFloor + energy.at(n));
+        onset[n] = qMax(0.0f, cur - prev);
+        prev = cur;
+    }
+
+    QVector<double> prefix(frames + 1, 0.0);
+    for (int n = 0; n < frames; ++n) prefix[n + 1] = prefix[n] + onset.at(n);
+    const int half = qMax(1, int(fps * kOnsetMeanSec / 2));
+    QVector<float> flux(frames);
+    for (int n = 0; n < frames; ++n) {
+        int lo = qMax(0, n - half);
+        int hi = qMin(frames, n + half + 1);
+        float mean = float((prefix[hi] - prefix[lo]) / (hi - lo));
+        flux[n] = qMax(0.0f, onset.at(n) - mean);
+    }
+
+    const int acfLags = 2 * maxLag;
+    QVector<double> acf(acfLags + 1);
+    for (int lag = 0; lag <= acfLags; ++lag) {
+        int count = frames - lag;
+        acf[lag] = dotProduct(flux.constData(), flux.constData() + lag, count) / count;
+    }
+    if (acf.at(0) <= 0) return false;
+
+    QVector<double> score(maxLag + 1, 0.0);
+    int best = -1;
+    for (int lag = minLag; lag <= maxLag; ++lag) {
+        double octaves = std::log2(60.0 * fps / lag / kPreferredBpm) / kTempoSpreadOctaves;
+        score[lag] = qExp(-0.5 * octaves * octaves) * (acf.at(lag) + 0.5 * acf.at(2 * lag));
+        if (best < 0 || score.at(lag) > score.at(best)) best = lag;
+    }
+    if (score.at(best) <= 0) return false;
+
+    double period = best;
+    if (best > minLag && best < maxLag) {
+        double a = score.at(best - 1), b = score.at(best), c = score.at(best + 1);
+        double denom = a - 2 * b + c;
+        if (denom < 0) period += 0.5 * (a - c) / denom;
+    }
+    grid.confidence = qBound(0.0, acf.at(best) / acf.at(0), 1.0);
+
+    // 自相关的周期误差会在整首歌上累积，在它附近细扫周期，和相位一起按梳状求和取最大
+    int phase = 0;
+    double refined = period;
+    double combSum = -1.0;
+    for (double candidate = period * (1.0 - kPeriodRefine); candidate <= period * (1.0 + kPeriodRefine);
+         candidate += kPeriodStepFrames) {
+        for (int p = 0; p < int(candidate); ++p) {
+            double sum = 0.0;
+            for (double t = p; t < frames; t += candidate) sum += flux.at(qMin(frames - 1, int(t + 0.5)));
+            if (sum > combSum) {
+                combSum = sum;
+                phase = p;
+                refined = candidate;
+            }
+        }
+    }
+    period = refined;
+    grid.bpm = 60.0 * fps / period;
+
+    const int window = qMax(1, int(period * kSnapFraction));
+    grid.beatsMs.clear();
+    for (double t = phase; t < frames; ) {
+        int center = int(t + 0.5);
+        int beat = center;
+        float peak = 0.0f;
+        for (int n = qMax(0, center - window); n <= qMin(frames - 1, center + window); ++n) {
+            if (flux.at(n) > peak) {
+                peak = flux.at(n);
+                beat = n;
+            }
+        }
+        grid.beatsMs.append(qint64(beat * 1000.0 / fps));
+        // 预测与实测各取一半，偶尔对到切分音上也不会把网格带偏
+        t = 0.5 * (beat + t) + period;
+    }
+    return !grid.beatsMs.isEmpty();
+}
+
+bool BeatWorker::analyze(QIODevice &pcm, BeatGrid &grid)
+{
+    QVector<float> energy;
+    energy.reserve(int(pcm.size() / qint64(sizeof(float)) / kHop) + 1);
+    QVector<float> buffer(kReadSamples);
+    qint64 total = 0;
+    for (;;) {
+        qint64 bytes = pcm.read(reinterpret_cast<char *>(buffer.data()), kReadSamples * qint64(sizeof(float)));
+        int got = int(bytes / qint64(sizeof(float)));
+        if (got <= 0) break;
+        total += got;
+        const float *samples = buffer.constData();
+        for (int i = 0; i + kHop <= got; i += kHop) {
+            energy.append(dotProduct(samples + i, samples + i, kHop) / kHop);
+        }
+    }
+    grid.durationMs = total * 1000 / kSampleRate;
+    return detectBeats(energy, grid);
+}
@@ -0,0 +1,30 @@
+/**
+ * @brief   : 节拍分析线程：解码成低采样率单声道 PCM，SIMD 内核求能量包络，
+ *            起音强度的自相关定出节拍周期，再逐拍对齐到起音峰值
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#ifndef BEATWORKER_H
+#define BEATWORKER_H
+
+#include <QIODevice>
+#include "analysisworker.h"
+
+class BeatAnalyzer;
+struct BeatGrid;
+
+class BeatWorker : public AnalysisWorker
+{
+    Q_OBJECT
+public:
+    BeatWorker(BeatAnalyzer *analyzer, AudioChunkCache *cache);
+
+protected:
+    bool process(int songId, const QString &url, QVariant &result) override;
+
+private:
+    bool detect(const QString &url, BeatGrid &grid);
+    static bool analyze(QIODevice &pcm, BeatGrid &grid);
+};
+
+#endif // BEATWORKER_H
@@ -0,0 +1,142 @@
+/**
+ * @brief   : 独立音频进程的通信约定：本地套接字上的命令/事件，共享内存里的状态环
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#ifndef ENGINEPROTOCOL_H
+#define ENGINEPROTOCOL_H
+
+#include <QString>
+#include <QDataStream>
+#include <atomic>
+
+/*
+ * 套接字上每条消息为 QDataStream 序列化的 quint8 类型 + QVariantList 参数。
+ * 位置、时长、播放状态变化频繁，不走套接字，统一由共享内存发布。
+ */
+static const QDataStream::Version kEngineStreamVersion = QDataStream::Qt_5_6;
+
+// 界面 -> 引擎
+enum EngineCommand {
+    CmdPlaySong = 1,     // songId, startMs
+    CmdQueueNextSong,    // songId
+    CmdProvideSongUrl,   // songId, url, gainDb, trimStartMs, trimEndMs
+    CmdClearQueue,
+    CmdPlay,
+    CmdPause,
+    CmdStop,
+    CmdSetVolume,        // vol
+    CmdSetPosition,      // ms
+    CmdSetCrossfade,     // seconds
+    CmdBeginScrub,
+    CmdScrubTo,          // ms
+    CmdEndScrub,         // ms
+    CmdSetAudioDevice,   // name
+    CmdSetLowLatency,    // enabled
+    CmdShutdown,         // 界面正常退出且设置了随界面停止，引擎随之结束
+    CmdSetDsp,           // DspSettings::toVariant()
+    CmdSetMetering,      // enabled
+    CmdSetSpeed          // speed
+};
+
+// 引擎 -> 界面（对应 AudioPlayer 的信号）
+enum EngineEvent {
+    EvtPlaybackFinished = 1,
+    EvtTrackAdvanced,
+    EvtStreamFailed,     // resumeMs, stalled
+    EvtSongUrlRequested, // songId
+    EvtBufferedRanges,   // start0, end0, start1, end1 ...
+    EvtAudioDevices,     // name0, description0, name1, description1 ...
+    EvtFirstAudio,       // latencyMs
+    EvtSeekCompleted,    // latencyMs, exact
+    EvtSeekWillStall,    // targetMs, expectedStallMs
+    EvtOutputLatency,    // ms
+    EvtRequestFailed,    // requestId, mpvError, message
+    EvtLevels,           // AudioLevels::toVariant()，约 25 Hz，只在电平表打开时发送
+    EvtStatusChanged     // 播放状态切换，或不在播放时位置/时长变化：界面读一次共享内存
+};
+
+// 每个播放区域一个引擎进程，按区域编号命名套接字和共享内存
+inline QString engineServerName(int zoneIndex)
+{
+    return QString("MusicAudioEngine-%1").arg(zoneIndex + 1);
+}
+
+inline QString engineStatusKey(const QString &serverName)
+{
+    return serverName + "-status";
+}
+
+/*-------------------------------
+ * 状态环：引擎按帧率写入，界面随时读取最新一项，读侧不加锁、不进内核。
+ * 每个槽位一个序号（奇数表示正在写），读前后序号一致才算读到完整快照；
+ * 多个槽位轮流写，读者不会被下一次写入立即覆盖。
+ *------------------------------*/
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+              "engine status ring requires address-free atomics");
+
+static const quint32 kEngineStatusMagic = 0x4d534531; // "MSE1"
+static const int kEngineStatusSlots = 8;
+
+struct EngineStatus {
+    qint64 positionMs = -1; // -1 表示没有曲目
+    qint64 durationMs = 0;
+    bool playing = false;
+};
+
+struct EngineStatusSlot {
+    std::atomic<quint32> seq;
+    std::atomic<qint64> positionMs;
+    std::atomic<qint64> durationMs;
+    std::atomic<qint32> playing;
+};
+
+struct EngineStatusRing {
+    quint32 magic;
+    std::atomic<quint32> writeCount; // 已发布的快照数，最新一项在 (writeCount - 1) % 槽位数
+    EngineStatusSlot entries[kEngineStatusSlots];
+};
+
+// 只有引擎一个写者
+inline void publishEngineStatus(EngineStatusRing *ring, const EngineStatus &status)
+{
+    const quint32 n = ring->writeCount.load(std::memory_order_relaxed);
+    EngineStatusSlot &slot = ring->entries[n % kEngineStatusSlots];
+    const quint32 seq = slot.seq.load(std::memory_order_relaxed);
+
+    slot.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.positionMs.store(status.positionMs, std::memory_order_relaxed);
+    slot.durationMs.store(status.durationMs, std::memory_order_relaxed);
+    slot.playing.store(status.playing ? 1 : 0, std::memory_order_relaxed);
+    slot.seq.store(seq + 2, std::memory_order_release);
+
+    ring->writeCount.store(n + 1, std::memory_order_release);
+}
+
+// 读到完整快照返回 true；引擎还没发布过或连续撞上写入时返回 false
+inline bool readEngineStatus(const EngineStatusRing *ring, EngineStatus &status)
+{
+    if (ring->magic != kEngineStatusMagic) return false;
+
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        const quint32 n = ring->writeCount.load(std::memory_order_acquire);
+        if (n == 0) return false;
+        const EngineStatusSlot &slot = ring->entries[(n - 1) % kEngineStatusSlots];
+
+        const quint32 seq = slot.seq.load(std::memory_order_acquire);
+        if (seq & 1) continue;
+        EngineStatus copy;
+        copy.positionMs = slot.positionMs.load(std::memory_order_relaxed);
+        copy.durationMs = slot.durationMs.load(std::memory_order_relaxed);
+        copy.playing = slot.playing.load(std::memory_order_relaxed) != 0;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) == seq) {
+            status = copy;
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif // ENGINEPROTOCOL_H
@@ -0,0 +1,158 @@
+/**
+ * @brief   : 均衡器调节窗口实现
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+
+#include "equalizerdialog.h"
+#include <QSlider>
+#include <QCheckBox>
+#include <QLabel>
+#include <QPushButton>
+#include <QGroupBox>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QFormLayout>
+
+// 均衡器每段的调节范围（dB）
+static const int kEqRangeDb = 12;
+
+EqualizerDialog::EqualizerDialog(QWidget *parent)
+    : QDialog(parent)
+{
+    setWindowTitle("均衡器");
+
+    QVBoxLayout *root = new QVBoxLayout(this);
+    m_enabled = new QCheckBox("启用音效", this);
+    root->addWidget(m_enabled);
+
+    // 均衡器：每段一个竖向滑块，下方显示频率
+    QGroupBox *eqBox = new QGroupBox("均衡器", this);
+    QHBoxLayout *eqLayout = new QHBoxLayout(eqBox);
+    for (int i = 0; i < kEqBandCount; ++i) {
+        QVBoxLayout *col = new QVBoxLayout;
+        QLabel *value = new QLabel(eqBox);
+        value->setAlignment(Qt::AlignCenter);
+        QSlider *slider = new QSlider(Qt::Vertical, eqBox);
+        slider->setRange(-kEqRangeDb, kEqRangeDb);
+        slider->setMinimumHeight(140);
+        double f = kEqBandFreqs[i];
+        QLabel *freq = new QLabel(f >= 1000 ? QString("%1k").arg(f / 1000) : QString::number(f), eqBox);
+        freq->setAlignment(Qt::AlignCenter);
+        col->addWidget(value);
+        col->addWidget(slider, 0, Qt::AlignHCenter);
+        col->addWidget(freq);
+        eqLayout->addLayout(col);
+        m_bands.append(slider);
+        m_bandLabels.append(value);
+        connect(slider, &QSlider::valueChanged, this, &EqualizerDialog::onControlChanged);
+    }
+    root->addWidget(eqBox);
+
+    // 压缩器与限幅器
+    QGroupBox *dynBox = new QGroupBox("动态", this);
+    QFormLayout *form = new QFormLayout(dynBox);
+    m_compEnabled = new QCheckBox("压缩器", dynBox);
+    form->addRow(m_compEnabled);
+    m_compThreshold = addSlider(form, "阈值", -60, 0, &m_compThresholdLabel);
+    m_compRatio = addSlider(form, "比例", 10, 200, &m_compRatioLabel);   // 比例 ×10
+    m_compMakeup = addSlider(form, "补偿增益", 0, 24, &m_compMakeupLabel);
+    m_limiterEnabled = new QCheckBox("限幅器", dynBox);
+    form->addRow(m_limiterEnabled);
+    m_limiterCeiling = addSlider(form, "上限", -12, 0, &m_limiterCeilingLabel);
+    root->addWidget(dynBox);
+
+    QPushButton *reset = new QPushButton("重置", this);
+    root->addWidget(reset, 0, Qt::AlignRight);
+
+    connect(m_enabled, &QCheckBox::toggled, this, &EqualizerDialog::onControlChanged);
+    connect(m_compEnabled, &QCheckBox::toggled, this, &EqualizerDialog::onControlChanged);
+    connect(m_limiterEnabled, &QCheckBox::toggled, this, &EqualizerDialog::onControlChanged);
+    connect(reset, &QPushButton::clicked, this, &EqualizerDialog::onReset);
+
+    setSettings(DspSettings());
+}
+
+QSlider *EqualizerDialog::addSlider(QFormLayout *form, const QString &name, int min, int max, QLabel **valueLabel)
+{
+    QSlider *slider = new QSlider(Qt::Horizontal, this);
+    slider->setRange(min, max);
+    *valueLabel = new QLabel(this);
+    (*valueLabel)->setMinimumWidth(60);
+
+    QHBoxLayout *row = new QHBoxLayout;
+    row->addWidget(slider);
+    row->addWidget(*valueLabel);
+    form->addRow(name, row);
+
+    connect(slider, &QSlider::valueChanged, this, &EqualizerDialog::onControlChanged);
+    return slider;
+}
+
+void EqualizerDialog::setSettings(const DspSettings &dsp)
+{
+    m_dsp = dsp;
+
+    // 批量刷新控件，不触发 onControlChanged
+    QList<QWidget *> controls;
+    controls << m_enabled << m_compEnabled << m_limiterEnabled
+             << m_compThreshold << m_compRatio << m_compMakeup << m_limiterCeiling;
+    for (QSlider *s : m_bands) controls << s;
+    for (QWidget *w : controls) w->blockSignals(true);
+
+    m_enabled->setChecked(dsp.enabled);
+    for (int i = 0; i < kEqBandCount; ++i) m_bands[i]->setValue(qRound(dsp.eqGainsDb.value(i)));
+    m_compEnabled->setChecked(dsp.compressorEnabled);
+    m_compThreshold->setValue(qRound(dsp.compThresholdDb));
+    m_compRatio->setValue(qRound(dsp.compRatio * 10));
+    m_compMakeup->setValue(qRound(dsp.compMakeupDb));
+    m_limiterEnabled->setChecked(dsp.limiterEnabled);
+    m_limiterCeiling->setValue(qRound(dsp.limiterCeilingDb));
+
+    for (QWidget *w : controls) w->blockSignals(false);
+    updateLabels();
+}
+
+void EqualizerDialog::onControlChanged()
+{
+    m_dsp.enabled = m_enabled->isChecked();
+    for (int i = 0; i < kEqBandCount; ++i) m_dsp.eqGainsDb[i] = m_bands[i]->value();
+    m_dsp.compressorEnabled = m_compEnabled->isChecked();
+    m_dsp.compThresholdDb = m_compThreshold->value();
+    m_dsp.compRatio = m_compRatio->value() / 10.0;
+    m_dsp.compMakeupDb = m_compMakeup->value();
+    m_dsp.limiterEnabled = m_limiterEnabled->isChecked();
+    m_dsp.limiterCeilingDb = m_limiterCeiling->value();
+
+    updateLabels();
+    emit settingsChanged(m_dsp);
+}
+
+void EqualizerDialog::onReset()
+{
+    // 参数回到默认，开关保持不变
+    DspSettings dsp;
+    dsp.enabled = m_dsp.enabled;
+    setSettings(dsp);
+    emit settingsChanged(m_dsp);
+}
+
+void EqualizerDialog::updateLabels()
+{
+    for (int i = 0; i < kEqBandCount; ++i) {
+        m_bandLabels[i]->setText(QString("%1").arg(m_bands[i]->value()));
+    }
+    m_compThresholdLabel->setText(QString("%1 dB").arg(m_compThreshold->value()));
+    m_compRatioLabel->setText(QString("%1 : 1").arg(m_compRatio->value() / 10.0, 0, 'f', 1));
+    m_compMakeupLabel->setText(QString("%1 dB").arg(m_compMakeup->value()));
+    m_limiterCeilingLabel->setText(QString("%1 dB").arg(m_limiterCeiling->value()));
+
+    bool on = m_enabled->isChecked();
+    for (QSlider *s : m_bands) s->setEnabled(on);
+    m_compEnabled->setEnabled(on);
+    m_limiterEnabled->setEnabled(on);
+    m_compThreshold->setEnabled(on && m_compEnabled->isChecked());
+    m_compRatio->setEnabled(on && m_compEnabled->isChecked());
+    m_compMakeup->setEnabled(on && m_compEnabled->isChecked());
+    m_limiterCeiling->setEnabled(on && m_limiterEnabled->isChecked());
+}
@@ -0,0 +1,57 @@
+/**
+ * @brief   : 均衡器/压缩器/限幅器调节窗口，拖动时实时发出参数（由播放器走 af-command 生效）
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+
+#ifndef EQUALIZERDIALOG_H
+#define EQUALIZERDIALOG_H
+
+#include <QDialog>
+#include <QVector>
+#include "audioplayer.h"
+
+class QSlider;
+class QCheckBox;
+class QLabel;
+class QFormLayout;
+
+class EqualizerDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit EqualizerDialog(QWidget *parent = nullptr);
+
+    // 刷新控件（切换区域/输出设备时），不会发出 settingsChanged
+    void setSettings(const DspSettings &dsp);
+    DspSettings settings() const { return m_dsp; }
+
+signals:
+    void settingsChanged(const DspSettings &dsp);
+
+private slots:
+    void onControlChanged();
+    void onReset();
+
+private:
+    QSlider *addSlider(QFormLayout *form, const QString &name, int min, int max, QLabel **valueLabel);
+    void updateLabels();
+
+    DspSettings m_dsp;
+    QCheckBox *m_enabled;
+    QVector<QSlider *> m_bands;
+    QVector<QLabel *> m_bandLabels;
+    QCheckBox *m_compEnabled;
+    QSlider *m_compThreshold;
+    QLabel *m_compThresholdLabel;
+    QSlider *m_compRatio;
+    QLabel *m_compRatioLabel;
+    QSlider *m_compMakeup;
+    QLabel *m_compMakeupLabel;
+    QCheckBox *m_limiterEnabled;
+    QSlider *m_limiterCeiling;
+    QLabel *m_limiterCeilingLabel;
+};
+
+#endif // EQUALIZERDIALOG_H
@@ -0,0 +1,107 @@
+/**
+ * @brief   : 声纹去重调度与存储实现
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#include "fingerprintindex.h"
+#include "fingerprintworker.h"
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QSettings>
+
+// 声纹文件：魔数、哈希数，之后每个哈希 6 字节（哈希值 + 锚点帧）
+static const char kCacheDir[] = "fingerprints";
+static const quint32 kCacheMagic = 0x4D465031; // "MFP1"
+static const quint32 kMaxHashes = 1 << 20;
+// 重复关系，键为 Songs/<歌曲 id>，值为代表 id
+static const char kStoreFile[] = "duplicates.ini";
+
+static QString cacheFile(int songId)
+{
+    return QString("%1/%2.fp").arg(kCacheDir).arg(songId);
+}
+
+FingerprintIndex::FingerprintIndex(AudioChunkCache *cache, QObject *parent)
+    : AnalysisQueue(cache, parent)
+{
+    QDir().mkpath(kCacheDir);
+
+    QSettings store(kStoreFile, QSettings::IniFormat);
+    store.beginGroup("Songs");
+    for (const QString &key : store.childKeys()) {
+        m_canonical.insert(key.toInt(), store.value(key).toInt());
+    }
+    store.endGroup();
+
+    startWorkers(1);
+}
+
+AnalysisWorker *FingerprintIndex::createWorker()
+{
+    return new FingerprintWorker(this, m_cache);
+}
+
+bool FingerprintIndex::jobFinished(int songId, const QVariant &result)
+{
+    int matchedId = result.toInt();
+    if (!matchedId) return true;
+
+    // 归到匹配歌曲所在的组，组内始终指向同一个代表
+    int canonical = canonicalId(matchedId);
+    if (canonical != songId) {
+        m_canonical.insert(songId, canonical);
+        QSettings store(kStoreFile, QSettings::IniFormat);
+        store.setValue("Songs/" + QString::number(songId), canonical);
+        emit duplicateFound(songId, canonical);
+    }
+    return true;
+}
+
+bool FingerprintIndex::load(int songId, QVector<FingerprintHash> &hashes)
+{
+    QFile file(cacheFile(songId));
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_6);
+    quint32 magic = 0, count = 0;
+    in >> magic >> count;
+    if (in.status() != QDataStream::Ok || magic != kCacheMagic || count > kMaxHashes) return false;
+
+    QVector<FingerprintHash> result(int(count));
+    for (FingerprintHash &h : result) in >> h.hash >> h.time;
+    if (in.status() != QDataStream::Ok) return false;
+    hashes = result;
+    return true;
+}
+
+bool FingerprintIndex::save(int songId, const QVector<FingerprintHash> &hashes)
+{
+    QSaveFile file(cacheFile(songId));
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_6);
+    out << kCacheMagic << quint32(hashes.size());
+    for (const FingerprintHash &h : hashes) out << h.hash << h.time;
+    return file.commit();
+}
+
+bool FingerprintIndex::isIndexed(int songId)
+{
+    return QFile::exists(cacheFile(songId));
+}
+
+QList<int> FingerprintIndex::indexedIds()
+{
+    QList<int> ids;
+    const QStringList files = QDir(kCacheDir).entryList(QStringList() << "*.fp", QDir::Files);
+    for (const QString &name : files) {
+        bool ok = false;
+        int id = name.section('.', 0, 0).toInt(&ok);
+        if (ok) ids.append(id);
+    }
+    return ids;
+}
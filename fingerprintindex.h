@@ -0,0 +1,53 @@
+/**
+ * @brief   : 声纹去重：后台线程解码每首歌中间的一小段，提取频谱峰值对组成的哈希，
+ *            在哈希索引里查找同一录音的其他歌曲 id，列表据此合并重复项，分块缓存据此共用数据
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#ifndef FINGERPRINTINDEX_H
+#define FINGERPRINTINDEX_H
+
+#include <QList>
+#include <QHash>
+#include <QVector>
+#include "analysisqueue.h"
+
+// 一个哈希：两个频谱峰值的频点和时间差；time 是锚点所在帧
+struct FingerprintHash {
+    quint32 hash;
+    quint16 time;
+};
+
+/*
+ * 只有一个处理线程：哈希索引归它独占，不需要加锁。
+ * 重复关系存在 duplicates.ini，启动时读回，界面线程随时可查。
+ */
+class FingerprintIndex : public AnalysisQueue
+{
+    Q_OBJECT
+public:
+    explicit FingerprintIndex(AudioChunkCache *cache, QObject *parent = nullptr);
+
+    // 同一录音的代表 id（最先建立声纹的那首）；没有重复时就是自己
+    int canonicalId(int songId) const { return m_canonical.value(songId, songId); }
+    QHash<int, int> duplicates() const { return m_canonical; }
+
+    // 声纹文件（fingerprints/<歌曲 id>.fp）
+    static bool load(int songId, QVector<FingerprintHash> &hashes);
+    static bool save(int songId, const QVector<FingerprintHash> &hashes);
+    static bool isIndexed(int songId);
+    static QList<int> indexedIds();
+
+signals:
+    void duplicateFound(int songId, int canonicalId);
+
+protected:
+    AnalysisWorker *createWorker() override;
+    bool isDone(int songId) const override { return isIndexed(songId); }
+    bool jobFinished(int songId, const QVariant &result) override; // result 为匹配的歌曲 id，0 表示没有
+
+private:
+    QHash<int, int> m_canonical; // 重复歌曲 id -> 代表 id
+};
+
+#endif // FINGERPRINTINDEX_H
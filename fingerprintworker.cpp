@@ -0,0 +1,283 @@
+/**
+ * @brief   : 声纹线程实现
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#include "fingerprintworker.h"
+#include "waveformworker.h"
+#include <QTemporaryFile>
+#include <QDir>
+#include <QtMath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define FINGERPRINT_USE_SSE
+#endif
+
+// 解码：8 kHz 单声道，只取第 15 秒起的 20 秒（前奏之后，不同版本的片头长短不影响）
+static const int kSampleRate = 8000;
+static const char kWindowOptions[] = "start=15,length=20";
+static const int kMinSamples = kSampleRate * 5;
+// 频谱：1024 点 FFT（约 7.8 Hz 一个频点），帧移 256（32 ms）
+static const int kFftSize = 1024;
+static const int kHop = 256;
+// 取峰值的频段（频点下标），约 78 Hz 到 2.5 kHz，按倍频程划分
+static const int kBandEdges[] = {10, 20, 40, 80, 160, 320};
+static const int kBandCount = int(sizeof(kBandEdges) / sizeof(kBandEdges[0])) - 1;
+// 低于这个功率的峰值视为静音，不参与配对
+static const float kPeakFloor = 1e-4f;
+// 配对：锚点之后 2..63 帧内的前几个峰值
+static const int kMinPairDt = 2;
+static const int kMaxPairDt = 63;
+static const int kFanOut = 3;
+// 判定为同一录音：同一时间偏移上（允许前后一帧）的命中数
+static const int kMinMatches = 20;
+static const double kMinMatchRatio = 0.05;
+
+FingerprintWorker::FingerprintWorker(FingerprintIndex *index, AudioChunkCache *cache)
+    : AnalysisWorker(index, cache)
+{
+}
+
+// 索引只在内存里：先把已有的声纹全部装进来，再开始处理新的
+bool FingerprintWorker::prepare()
+{
+    const QList<int> ids = FingerprintIndex::indexedIds();
+    for (int id : ids) {
+        if (isQuitting()) return false;
+        QVector<FingerprintHash> hashes;
+        if (FingerprintIndex::load(id, hashes)) insert(id, hashes);
+    }
+    return true;
+}
+
+bool FingerprintWorker::process(int songId, const QString &url, QVariant &result)
+{
+    QVector<float> samples;
+    if (!decode(url, samples) || samples.size() < kMinSamples) return false;
+
+    QVector<FingerprintHash> hashes = extract(samples);
+    int matched = match(songId, hashes);
+    if (!FingerprintIndex::save(songId, hashes)) return false;
+    insert(songId, hashes);
+    result = matched;
+    return true;
+}
+
+bool FingerprintWorker::decode(const QString &url, QVector<float> &samples)
+{
+    QTemporaryFile pcm(QDir::temp().filePath("music-fingerprint-XXXXXX.pcm"));
+    if (!pcm.open()) return false;
+    pcm.close();
+
+    auto cancelled = [this]() { return isQuitting(); };
+    auto paused = [this]() { return isPaused(); };
+    if (!WaveformWorker::decodePcm(url, pcm.fileName(), kSampleRate, m_cache, kWindowOptions, cancelled, paused))
+        return false;
+    if (!pcm.open()) return false;
+
+    samples.resize(int(pcm.size() / qint64(sizeof(float))));
+    qint64 bytes = samples.size() * qint64(sizeof(float));
+    return pcm.read(reinterpret_cast<char *>(samples.data()), bytes) == bytes;
+}
+
+/*-------------------------------
+ * 基 2 FFT：实部、虚部分开存放，每一级的旋转因子连续排列，
+ * 蝶形跨度不小于 4 时 SSE 一次算 4 个
+ *------------------------------*/
+struct FftPlan {
+    QVector<int> bitReverse;
+    QVector<float> twiddleRe; // 第 m 级（半长 m）的因子从下标 m - 1 开始
+    QVector<float> twiddleIm;
+    QVector<float> window;    // Hann 窗
+};
+
+static FftPlan makePlan(int n)
+{
+    FftPlan plan;
+    int bits = 0;
+    while ((1 << bits) < n) ++bits;
+    plan.bitReverse.resize(n);
+    for (int i = 0; i < n; ++i) {
+        int r = 0;
+        for (int b = 0; b < bits; ++b) r |= ((i >> b) & 1) << (bits - 1 - b);
+        plan.bitReverse[i] = r;
+    }
+    for (int m = 1; m < n; m <<= 1) {
+        for (int j = 0; j < m; ++j) {
+            double angle = -M_PI * j / m;
+            plan.twiddleRe.append(float(qCos(angle)));
+            plan.twiddleIm.append(float(qSin(angle)));
+        }
+    }
+    plan.window.resize(n);
+    for (int i = 0; i < n; ++i) plan.window[i] = float(0.5 - 0.5 * qCos(2 * M_PI * i / n));
+    return plan;
+}
+
+static void fft(const FftPlan &plan, float *re, float *im, int n)
+{
+    for (int i = 0; i < n; ++i) {
+        int j = plan.bitReverse.at(i);
+        if (j > i) {
+            qSwap(re[i], re[j]);
+            qSwap(im[i], im[j]);
+        }
+    }
+    for (int m = 1; m < n; m <<= 1) {
+        const float *wr = plan.twiddleRe.constData() + (m - 1);
+        const float *wi = plan.twiddleIm.constData() + (m - 1);
+        for (int start = 0; start < n; start += 2 * m) {
+            float *ar = re + start, *ai = im + start;
+            float *br = ar + m, *bi = ai + m;
+            int j = 0;
+#ifdef FINGERPRINT_USE_SSE
+            for (; j + 4 <= m; j += 4) {
+                __m128 xr = _mm_loadu_ps(br + j), xi = _mm_loadu_ps(bi + j);
+                __m128 cr = _mm_loadu_ps(wr + j), ci = _mm_loadu_ps(wi + j);
+                __m128 tr = _mm_sub_ps(_mm_mul_ps(xr, cr), _mm_mul_ps(xi, ci));
+                __m128 ti = _mm_add_ps(_mm_mul_ps(xr, ci), _mm_mul_ps(xi, cr));
+                __m128 yr = _mm_loadu_ps(ar + j), yi = _mm_loadu_ps(ai + j);
+                _mm_storeu_ps(ar + j, _mm_add_ps(yr, tr));
+                _mm_storeu_ps(ai + j, _mm_add_ps(yi, ti));
+                _mm_storeu_ps(br + j, _mm_sub_ps(yr, tr));
+                _mm_storeu_ps(bi + j, _mm_sub_ps(yi, ti));
+            }
+#endif
+            for (; j < m; ++j) {
+                float tr = br[j] * wr[j] - bi[j] * wi[j];
+                float ti = br[j] * wi[j] + bi[j] * wr[j];
+                br[j] = ar[j] - tr;
+                bi[j] = ai[j] - ti;
+                ar[j] += tr;
+                ai[j] += ti;
+            }
+        }
+    }
+}
+
+// 加窗并清零虚部
+static void applyWindow(const float *samples, const float *window, float *re, float *im, int n)
+{
+    int i = 0;
+#ifdef FINGERPRINT_USE_SSE
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(re + i, _mm_mul_ps(_mm_loadu_ps(samples + i), _mm_loadu_ps(window + i)));
+        _mm_storeu_ps(im + i, zero);
+    }
+#endif
+    for (; i < n; ++i) {
+        re[i] = samples[i] * window[i];
+        im[i] = 0.0f;
+    }
+}
+
+static void powerSpectrum(const float *re, const float *im, float *power, int bins)
+{
+    int i = 0;
+#ifdef FINGERPRINT_USE_SSE
+    for (; i + 4 <= bins; i += 4) {
+        __m128 r = _mm_loadu_ps(re + i), m = _mm_loadu_ps(im + i);
+        _mm_storeu_ps(power + i, _mm_add_ps(_mm_mul_ps(r, r), _mm_mul_ps(m, m)));
+    }
+#endif
+    for (; i < bins; ++i) power[i] = re[i] * re[i] + im[i] * im[i];
+}
+
+// [from, to) 内功率最大的频点：SSE 求最大值，再找出它的位置
+static int strongestBin(const float *power, int from, int to)
+{
+    float best = power[from];
+    int i = from;
+#ifdef FINGERPRINT_USE_SSE
+    if (to - from >= 4) {
+        __m128 vmax = _mm_loadu_ps(power + from);
+        for (i = from + 4; i + 4 <= to; i += 4) vmax = _mm_max_ps(vmax, _mm_loadu_ps(power + i));
+        float lanes[4];
+        _mm_storeu_ps(lanes, vmax);
+        best = qMax(qMax(lanes[0], lanes[1]), qMax(lanes[2], lanes[3]));
+    }
+#endif
+    for (; i < to; ++i) best = qMax(best, power[i]);
+    for (i = from; i < to; ++i) {
+        if (power[i] == best) return i;
+    }
+    return from;
+}
+
+/*-------------------------------
+ * 每帧在各频段取最强的频点作为峰值，锚点与它之后一段时间内的几个峰值配对：
+ * 哈希 = 锚点频点(9 位) | 目标频点(9 位) | 帧差(6 位)，只和相对时间有关，
+ * 两段音频起点不同也能对上
+ *------------------------------*/
+QVector<FingerprintHash> FingerprintWorker::extract(const QVector<float> &samples)
+{
+    static const FftPlan plan = makePlan(kFftSize);
+    Q_STATIC_ASSERT(kFftSize / 2 <= 512 && kMaxPairDt < 64);
+
+    struct Peak {
+        int time;
+        int bin;
+    };
+    QVector<Peak> peaks;
+    QVector<float> re(kFftSize), im(kFftSize), power(kFftSize / 2);
+    for (int frame = 0; frame * kHop + kFftSize <= samples.size(); ++frame) {
+        applyWindow(samples.constData() + frame * kHop, plan.window.constData(), re.data(), im.data(), kFftSize);
+        fft(plan, re.data(), im.data(), kFftSize);
+        powerSpectrum(re.constData(), im.constData(), power.data(), kFftSize / 2);
+        for (int b = 0; b < kBandCount; ++b) {
+            int bin = strongestBin(power.constData(), kBandEdges[b], kBandEdges[b + 1]);
+            if (power.at(bin) >= kPeakFloor) peaks.append(Peak{frame, bin});
+        }
+    }
+
+    QVector<FingerprintHash> hashes;
+    for (int i = 0; i < peaks.size(); ++i) {
+        const Peak &anchor = peaks.at(i);
+        int paired = 0;
+        for (int j = i + 1; j < peaks.size() && paired < kFanOut; ++j) {
+            int dt = peaks.at(j).time - anchor.time;
+            if (dt < kMinPairDt) continue;
+            if (dt > kMaxPairDt) break;
+            quint32 hash = (quint32(anchor.bin) << 15) | (quint32(peaks.at(j).bin) << 6) | quint32(dt);
+            hashes.append(FingerprintHash{hash, quint16(anchor.time)});
+            ++paired;
+        }
+    }
+    return hashes;
+}
+
+/*-------------------------------
+ * 按（歌曲，时间偏移）投票：同一录音的哈希集中在一个偏移上，
+ * 偶然相同的哈希分散在各处。编码器延迟可能差一帧，相邻偏移合并计票
+ *------------------------------*/
+int FingerprintWorker::match(int songId, const QVector<FingerprintHash> &hashes) const
+{
+    QHash<qint64, int> votes;
+    for (const FingerprintHash &h : hashes) {
+        auto it = m_postings.constFind(h.hash);
+        if (it == m_postings.constEnd()) continue;
+        for (const Posting &p : *it) {
+            if (p.songId == songId) continue;
+            qint64 key = (qint64(p.songId) << 32) | quint32(int(p.time) - int(h.time) + 65536);
+            ++votes[key];
+        }
+    }
+
+    int bestId = 0, bestCount = 0;
+    for (auto it = votes.constBegin(); it != votes.constEnd(); ++it) {
+        int count = it.value() + votes.value(it.key() - 1) + votes.value(it.key() + 1);
+        if (count > bestCount) {
+            bestCount = count;
+            bestId = int(it.key() >> 32);
+        }
+    }
+    if (bestCount < kMinMatches || bestCount < hashes.size() * kMinMatchRatio) return 0;
+    return bestId;
+}
+
+void FingerprintWorker::insert(int songId, const QVector<FingerprintHash> &hashes)
+{
+    for (const FingerprintHash &h : hashes) m_postings[h.hash].append(Posting{songId, h.time});
+}
@@ -0,0 +1,39 @@
+/**
+ * @brief   : 声纹线程：解码一小段低采样率 PCM，SIMD 的 FFT 求功率谱，
+ *            每帧各频段取峰值，相邻峰值两两配对成哈希；独占哈希索引做匹配
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#ifndef FINGERPRINTWORKER_H
+#define FINGERPRINTWORKER_H
+
+#include <QHash>
+#include <QVector>
+#include "analysisworker.h"
+#include "fingerprintindex.h"
+
+class FingerprintWorker : public AnalysisWorker
+{
+    Q_OBJECT
+public:
+    FingerprintWorker(FingerprintIndex *index, AudioChunkCache *cache);
+
+protected:
+    bool prepare() override;
+    bool process(int songId, const QString &url, QVariant &result) override;
+
+private:
+    struct Posting {
+        int songId;
+        quint16 time;
+    };
+
+    bool decode(const QString &url, QVector<float> &samples);
+    static QVector<FingerprintHash> extract(const QVector<float> &samples);
+    int match(int songId, const QVector<FingerprintHash> &hashes) const; // 返回匹配的歌曲 id，0 表示没有
+    void insert(int songId, const QVector<FingerprintHash> &hashes);
+
+    QHash<quint32, QVector<Posting>> m_postings; // 哈希 -> 出现在哪些歌曲的哪一帧
+};
+
+#endif // FINGERPRINTWORKER_H
@@ -0,0 +1,81 @@
+/**
+ * @brief   : 后台响度扫描实现
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#include "loudnessscanner.h"
+#include "loudnessworker.h"
+#include <QSettings>
+#include <QStringList>
+
+// 测量结果存放文件，键为 Tracks/<歌曲 id>，值为“整体响度, 真峰值”
+static const char kStoreFile[] = "loudness.ini";
+// 扫描线程数上限：每个线程都是一个完整的 mpv 内核
+static const int kMaxWorkers = 2;
+// 归一化目标（LUFS，与 ReplayGain 2.0 一致）和真峰值上限（dBTP）
+static const double kDefaultTargetLufs = -18.0;
+static const double kPeakCeilingDb = -1.0;
+// 增益范围（dB）；低于静音门限的结果不做归一化
+static const double kMinGainDb = -24.0;
+static const double kMaxGainDb = 12.0;
+static const double kSilenceLufs = -70.0;
+
+static QString storeKey(int songId)
+{
+    return "Tracks/" + QString::number(songId);
+}
+
+LoudnessScanner::LoudnessScanner(AudioChunkCache *cache, QObject *parent)
+    : AnalysisQueue(cache, parent)
+{
+    QSettings st("settings.ini", QSettings::IniFormat);
+    startWorkers(qBound(0, st.value("Loudness/workers", 1).toInt(), kMaxWorkers));
+}
+
+AnalysisWorker *LoudnessScanner::createWorker()
+{
+    return new LoudnessWorker(this, m_cache);
+}
+
+// 扫描线程给出“整体响度, 真峰值”
+bool LoudnessScanner::jobFinished(int songId, const QVariant &result)
+{
+    const QVariantList values = result.toList();
+    if (values.size() < 2) return false;
+    double integratedLufs = values.at(0).toDouble();
+    double truePeakDb = values.at(1).toDouble();
+
+    QSettings store(kStoreFile, QSettings::IniFormat);
+    store.setValue(storeKey(songId), QStringList()
+                   << QString::number(integratedLufs, 'f', 2)
+                   << QString::number(truePeakDb, 'f', 2));
+    emit trackScanned(songId, integratedLufs, truePeakDb);
+    return true;
+}
+
+bool LoudnessScanner::isScanned(int songId)
+{
+    QSettings store(kStoreFile, QSettings::IniFormat);
+    return store.contains(storeKey(songId));
+}
+
+/*-------------------------------
+ * 增益 = 目标响度 - 整体响度，且加上增益后的真峰值不超过上限：
+ * 动态大、峰值高的曲目宁可偏小声，也不削波
+ *------------------------------*/
+double LoudnessScanner::gainDb(int songId)
+{
+    QSettings st("settings.ini", QSettings::IniFormat);
+    if (!st.value("Loudness/normalize", true).toBool()) return 0.0;
+    double target = st.value("Loudness/targetLufs", kDefaultTargetLufs).toDouble();
+
+    QSettings store(kStoreFile, QSettings::IniFormat);
+    const QStringList values = store.value(storeKey(songId)).toStringList();
+    if (values.size() < 2) return 0.0;
+    double lufs = values.at(0).toDouble();
+    double peak = values.at(1).toDouble();
+    if (lufs <= kSilenceLufs) return 0.0;
+
+    double gain = qMin(target - lufs, kPeakCeilingDb - peak);
+    return qBound(kMinGainDb, gain, kMaxGainDb);
+}
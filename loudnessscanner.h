@@ -0,0 +1,36 @@
+/**
+ * @brief   : 后台响度扫描：少量无头 mpv 内核以最低优先级跑 EBU R128，
+ *            结果按歌曲 id 存进 loudness.ini，播放时换算成归一化增益
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#ifndef LOUDNESSSCANNER_H
+#define LOUDNESSSCANNER_H
+
+#include "analysisqueue.h"
+
+/*
+ * 地址在真正开始扫描前才请求，不会因为排队太久而过期；
+ * 扫描经由分块缓存读取，扫过的歌曲播放时不再下载，反之亦然。
+ */
+class LoudnessScanner : public AnalysisQueue
+{
+    Q_OBJECT
+public:
+    // 并发数来自 settings.ini 的 Loudness/workers（默认 1，0 表示不扫描）
+    explicit LoudnessScanner(AudioChunkCache *cache, QObject *parent = nullptr);
+
+    // 测量结果与归一化增益（dB），未测量或在 settings.ini 关闭了归一化时为 0；任何进程都可调用
+    static bool isScanned(int songId);
+    static double gainDb(int songId);
+
+signals:
+    void trackScanned(int songId, double integratedLufs, double truePeakDb);
+
+protected:
+    AnalysisWorker *createWorker() override;
+    bool isDone(int songId) const override { return isScanned(songId); }
+    bool jobFinished(int songId, const QVariant &result) override;
+};
+
+#endif // LOUDNESSSCANNER_H
@@ -0,0 +1,173 @@
+/**
+ * @brief   : 响度扫描线程实现
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#include "loudnessworker.h"
+#include "loudnessscanner.h"
+#include "audiochunkcache.h"
+#include "mpvplayer.h"
+#include <QDebug>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+
+// eof-reached 的订阅 id
+static const quint64 kEofReachedId = 1;
+// 等待事件的超时（秒），期间检查暂停和退出
+static const double kPollSec = 0.2;
+// 换算 dB 时峰值的下限（-120 dB），全静音时不至于取到 -inf
+static const double kMinPeak = 1e-6;
+
+LoudnessWorker::LoudnessWorker(LoudnessScanner *scanner, AudioChunkCache *cache)
+    : AnalysisWorker(scanner, cache),
+      m_mpv(nullptr)
+{
+}
+
+/*-------------------------------
+ * 无头分析内核：
+ * 1. ao=null 且不按时钟输出，解码多快就测多快
+ * 2. keep-open：播到末尾停在最后一帧，滤镜图保留，才能读到累计结果
+ * 3. ebur128 的读数随帧写进 af-metadata/r128，其中 I 是到当前为止的整体响度
+ *------------------------------*/
+mpv_handle *LoudnessWorker::createCore()
+{
+    mpv_handle *mpv = mpv_create();
+    if (!mpv) return nullptr;
+
+    MPVPlayer::applyAudioOnlyProfile(mpv);
+    mpv_set_option_string(mpv, "ao", "null");
+    mpv_set_option_string(mpv, "ao-null-untimed", "yes");
+    mpv_set_option_string(mpv, "keep-open", "yes");
+    mpv_set_option_string(mpv, "af", "@r128:lavfi=[ebur128=metadata=1:peak=true]");
+
+    if (mpv_initialize(mpv) < 0) {
+        mpv_terminate_destroy(mpv);
+        return nullptr;
+    }
+    mpv_observe_property(mpv, kEofReachedId, "eof-reached", MPV_FORMAT_FLAG);
+    if (m_cache) m_cache->registerWith(mpv);
+    return mpv;
+}
+
+bool LoudnessWorker::prepare()
+{
+    m_mpv = createCore();
+    if (!m_mpv) {
+        qWarning() << "loudness scanner: mpv init failed";
+        return false;
+    }
+    return true;
+}
+
+bool LoudnessWorker::process(int songId, const QString &url, QVariant &result)
+{
+    Q_UNUSED(songId);
+    double lufs = 0.0, peak = 0.0;
+    if (!scan(m_mpv, url, lufs, peak)) return false;
+    result = QVariantList() << lufs << peak;
+    return true;
+}
+
+void LoudnessWorker::finish()
+{
+    mpv_terminate_destroy(m_mpv);
+    m_mpv = nullptr;
+}
+
+// af-metadata 的值都是字符串
+static bool metadataValue(const mpv_node *map, const char *key, double &value)
+{
+    if (!map || map->format != MPV_FORMAT_NODE_MAP) return false;
+    for (int i = 0; i < map->u.list->num; ++i) {
+        const mpv_node *v = &map->u.list->values[i];
+        if (strcmp(map->u.list->keys[i], key) == 0 && v->format == MPV_FORMAT_STRING) {
+            value = strtod(v->u.string, nullptr);
+            return true;
+        }
+    }
+    return false;
+}
+
+/*-------------------------------
+ * ebur128 的峰值读数是线性幅度（1.0 为满刻度），不是 dB。
+ * 新版本给出 <name>（各声道最大值），旧版本只有逐声道的 <name>s_chN，取最大值
+ *------------------------------*/
+static bool metadataPeak(const mpv_node *map, const char *name, double &peak)
+{
+    if (!map || map->format != MPV_FORMAT_NODE_MAP) return false;
+    const QByteArray key = QByteArray("lavfi.r128.") + name;
+    const QByteArray channelPrefix = key + "s_ch";
+    bool found = false;
+    for (int i = 0; i < map->u.list->num; ++i) {
+        const mpv_node *v = &map->u.list->values[i];
+        const char *k = map->u.list->keys[i];
+        if (v->format != MPV_FORMAT_STRING) continue;
+        if (key != k && strncmp(k, channelPrefix.constData(), size_t(channelPrefix.size())) != 0) continue;
+        double value = strtod(v->u.string, nullptr);
+        peak = found ? qMax(peak, value) : value;
+        found = true;
+    }
+    return found;
+}
+
+bool LoudnessWorker::scan(mpv_handle *mpv, const QString &url, double &integratedLufs, double &truePeakDb)
+{
+    mpv_set_property_string(mpv, "pause", "no");
+    QByteArray target = url.toUtf8();
+    const char *load[] = {"loadfile", target.constData(), nullptr};
+    if (mpv_command(mpv, load) < 0) return false;
+
+    bool started = false; // 上一首 stop 产生的事件在 START_FILE 之前，忽略
+    bool paused = false;
+    bool done = false;
+    bool ok = false;
+    while (!done) {
+        if (isQuitting()) break;
+
+        // 让出：暂停解码，也就不再从网络读取
+        bool wantPause = isPaused();
+        if (wantPause != paused) {
+            paused = wantPause;
+            mpv_set_property_string(mpv, "pause", paused ? "yes" : "no");
+        }
+
+        mpv_event *event = mpv_wait_event(mpv, kPollSec);
+        switch (event->event_id) {
+        case MPV_EVENT_START_FILE:
+            started = true;
+            break;
+        case MPV_EVENT_END_FILE:
+            // keep-open 下正常播完不会结束文件，走到这里说明出错
+            if (started) done = true;
+            break;
+        case MPV_EVENT_PROPERTY_CHANGE: {
+            const mpv_event_property *prop = (const mpv_event_property *)event->data;
+            if (!started || event->reply_userdata != kEofReachedId
+                    || prop->format != MPV_FORMAT_FLAG || !*(int *)prop->data) break;
+            mpv_node node;
+            if (mpv_get_property(mpv, "af-metadata/r128", MPV_FORMAT_NODE, &node) >= 0) {
+                ok = metadataValue(&node, "lavfi.r128.I", integratedLufs);
+                // 没有真峰值时退而用采样峰值，都没有则按满刻度保守处理
+                double peak = 1.0;
+                if (!metadataPeak(&node, "true_peak", peak))
+                    metadataPeak(&node, "sample_peak", peak);
+                truePeakDb = 20.0 * std::log10(qMax(peak, kMinPeak));
+                mpv_free_node_contents(&node);
+            }
+            done = true;
+            break;
+        }
+        case MPV_EVENT_SHUTDOWN:
+            done = true;
+            break;
+        default:
+            break;
+        }
+    }
+
+    const char *stop[] = {"stop", nullptr};
+    mpv_command(mpv, stop);
+    return ok;
+}
@@ -0,0 +1,35 @@
+/**
+ * @brief   : 响度扫描线程：一个无头 mpv 内核（ao=null、不按时钟解码），
+ *            经 ebur128 滤镜测出整体响度和真峰值
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#ifndef LOUDNESSWORKER_H
+#define LOUDNESSWORKER_H
+
+#include <mpv/client.h>
+#include "analysisworker.h"
+
+class LoudnessScanner;
+
+// 一个内核扫完所有分到的歌曲，歌曲之间只 stop 不重建
+class LoudnessWorker : public AnalysisWorker
+{
+    Q_OBJECT
+public:
+    LoudnessWorker(LoudnessScanner *scanner, AudioChunkCache *cache);
+
+protected:
+    bool prepare() override;
+    bool process(int songId, const QString &url, QVariant &result) override;
+    void finish() override;
+
+private:
+    mpv_handle *createCore();
+    // 扫描一首歌，播到文件末尾后读出 ebur128 的累计结果
+    bool scan(mpv_handle *mpv, const QString &url, double &integratedLufs, double &truePeakDb);
+
+    mpv_handle *m_mpv;
+};
+
+#endif // LOUDNESSWORKER_H
@@ -5,9 +5,25 @@
  **/
 #include <QApplication>
 #include "mainwindow.h"
+#include "audioengine.h"
+#include "searchlistparser.h"
 
 int main(int argc, char *argv[])
 {
+    // 独立音频进程：Music --audio-engine <名称>，由 RemotePlayer 以分离方式拉起
+    if (argc >= 3 && qstrcmp(argv[1], "--audio-engine") == 0) {
+        QCoreApplication engineApp(argc, argv);
+        AudioEngine engine(QString::fromLocal8Bit(argv[2]));
+        if (!engine.start()) return 0; // 同名引擎已在运行
+        return engineApp.exec();
+    }
+
+    // 列表 JSON 解析基准：Music --bench-json [条数]，两种解析对照并输出吞吐量
+    if (argc >= 2 && qstrcmp(argv[1], "--bench-json") == 0) {
+        QCoreApplication benchApp(argc, argv);
+        return SearchListParser::benchmark(argc >= 3 ? atoi(argv[2]) : 10000);
+    }
+
     // 启用 Qt 高 DPI 缩放
     QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);      // 整体缩放
     QCoreApplication::setAttribute(Qt::AA_UseHighDpiPixmaps);        // 图片不模糊
@@ -6,26 +6,63 @@
 
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include <QCoreApplication>
 #include <QDebug>
 #include <QSettings>
+#include <QSignalBlocker>
 #include <QRandomGenerator>
+#include <QSet>
+#include <QUrl>
+#include <algorithm>
+
+// 断线续播的最大重试次数与首次重试延迟（之后每次翻倍）
+static const int kMaxStreamRetries = 4;
+static const int kRetryBaseDelayMs = 1000;
+// 单进程最多驱动的播放区域数
+static const int kMaxZones = 16;
+// 起播/续播时暂停响度扫描的时长（毫秒），出声后再多让一小段给预读
+static const int kScanYieldLoadMs = 10000;
+static const int kScanYieldAfterStartMs = 2000;
+// 速度视图的分档（BPM）
+static const double kSlowBpm = 90.0;
+static const double kFastBpm = 130.0;
+// 淡入淡出对拍：节奏不明显的曲目不对齐；裁剪点离最近一拍太远时也不动
+static const double kMinBeatConfidence = 0.15;
+static const qint64 kMaxBeatSnapMs = 1500;
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent),
       ui(new Ui::MainWindow),
-      m_net(new NetworkManager(this)),
-      m_player(new MPVPlayer(this)),
-      m_currentIndex(-1)
+      m_net(new NetworkManager),
+      m_chunkCache(new AudioChunkCache(m_net, this)),
+      m_scanner(new LoudnessScanner(m_chunkCache, this)),
+      m_waveforms(new WaveformGenerator(m_chunkCache, this)),
+      m_waveformSongId(0),
+      m_beats(new BeatAnalyzer(m_chunkCache, this)),
+      m_fingerprints(new FingerprintIndex(m_chunkCache, this)),
+      m_zone(nullptr),
+      m_dspDialog(nullptr),
+      m_dspSaveZone(nullptr),
+      m_sync(nullptr)
 {
     ui->setupUi(this);
 
-    on_host_btn_clicked();
+    // 区域数在 settings.ini 中配置，默认只有一个（此时不显示区域选择）
+    {
+        QSettings st("settings.ini", QSettings::IniFormat);
+        int zoneCount = qBound(1, st.value("Zones/count", 1).toInt(), kMaxZones);
+        for (int i = 0; i < zoneCount; ++i) {
+            m_zones.append(createZone(i));
+            ui->comboZone->addItem(QString("区域 %1").arg(i + 1));
+        }
+        ui->comboZone->setVisible(zoneCount > 1);
+    }
+    m_zone = m_zones.first();
 
-    m_playMode = PlaySequence;   // 默认顺序播放
+    on_host_btn_clicked();
 
     // 初始化 UI 初始状态（保持和 .ui 名称一致）
     ui->sliderVolume->setRange(0, 100);
-    ui->sliderVolume->setValue(80);
     ui->sliderPosition->setRange(0, 0);
     ui->labelTitle->setText("");
     ui->labelArtist->setText("");
@@ -36,12 +73,90 @@ MainWindow::MainWindow(QWidget *parent)
     connect(m_net, &NetworkManager::searchFinished, this, &MainWindow::onSearchFinished);
     connect(m_net, &NetworkManager::getUrlFinished, this, &MainWindow::onGetUrlFinished);
     connect(m_net, &NetworkManager::imageFetched, this, &MainWindow::onImageFetched);
-
-    // 连接 MPVPlayer 信号
-    connect(m_player, &MPVPlayer::positionChanged, this, &MainWindow::onPositionChanged);
-    connect(m_player, &MPVPlayer::durationChanged, this, &MainWindow::onDurationChanged);
-    connect(m_player, &MPVPlayer::stateChanged, this, &MainWindow::onPlayerStateChanged);
-    connect(m_player, &MPVPlayer::playbackFinished,this, &MainWindow::onPlaybackFinished);
+    connect(m_chunkCache, &AudioChunkCache::sourceExpired, this, [this](int songId) {
+        requestUrl(songId, UrlRefresh);
+    });
+
+    // 歌词/进度文字按帧率读取插值时钟，不依赖 positionChanged 的到达频率
+    m_frameTimer.setInterval(16);
+    connect(&m_frameTimer, &QTimer::timeout, this, &MainWindow::onFrameTick);
+
+    m_dspSaveTimer.setSingleShot(true);
+    m_dspSaveTimer.setInterval(500);
+    connect(&m_dspSaveTimer, &QTimer::timeout, this, &MainWindow::saveDspPreset);
+
+    // 响度扫描：地址临到扫描才解析，收藏的歌曲启动时全部排队
+    connect(m_scanner, &LoudnessScanner::songUrlRequested, this, [this](int songId) {
+        requestUrl(songId, UrlScan);
+    });
+    for (int id : favoriteIds()) m_scanner->enqueue(id);
+
+    // 波形概览：只显示界面当前曲目的，其余的生成后留在缓存里
+    connect(m_waveforms, &WaveformGenerator::songUrlRequested, this, [this](int songId) {
+        requestUrl(songId, UrlWaveform);
+    });
+    connect(m_waveforms, &WaveformGenerator::waveformReady, this, [this](int songId, const Waveform &waveform) {
+        if (songId == m_waveformSongId) ui->sliderPosition->setWaveform(waveform);
+    });
+
+    // 节拍分析：收藏的歌曲启动时全部排队（算法更新后的批量重扫也走这里）；
+    // 按速度查看列表时，结果陆续到达，合并后刷新一次
+    connect(m_beats, &BeatAnalyzer::songUrlRequested, this, [this](int songId) {
+        requestUrl(songId, UrlBeats);
+    });
+    connect(m_beats, &BeatAnalyzer::beatsReady, this, [this](int songId) {
+        if (ui->comboTempo->currentIndex() == TempoAll) return;
+        for (const auto &song : m_searchList) {
+            if (song.id == songId) {
+                m_listRefreshTimer.start();
+                return;
+            }
+        }
+    });
+    for (int id : favoriteIds()) m_beats->enqueue(id);
+    m_listRefreshTimer.setSingleShot(true);
+    m_listRefreshTimer.setInterval(500);
+    connect(&m_listRefreshTimer, &QTimer::timeout, this, &MainWindow::refreshResultList);
+
+    // 声纹去重：已知的重复关系先交给分块缓存，新发现的重复合并到列表里
+    connect(m_fingerprints, &FingerprintIndex::songUrlRequested, this, [this](int songId) {
+        requestUrl(songId, UrlFingerprint);
+    });
+    connect(m_fingerprints, &FingerprintIndex::duplicateFound, this, [this](int songId, int canonicalId) {
+        m_chunkCache->setDuplicate(songId, canonicalId);
+        for (const auto &song : m_searchList) {
+            if (song.id == songId) {
+                m_listRefreshTimer.start();
+                return;
+            }
+        }
+    });
+    const QHash<int, int> duplicates = m_fingerprints->duplicates();
+    for (auto it = duplicates.constBegin(); it != duplicates.constEnd(); ++it) {
+        m_chunkCache->setDuplicate(it.key(), it.value());
+    }
+    for (int id : favoriteIds()) m_fingerprints->enqueue(id);
+
+    // 电平表不可见（窗口最小化等）时关掉测量，播放器不再插入测量滤镜
+    connect(ui->meterWidget, &MeterWidget::visibilityChanged, this, [this](bool visible) {
+        if (m_zone) m_zone->player->setMetering(visible);
+    });
+
+    // 界面绑定到第一个区域（音量、设备、进度等都从区域恢复）
+    bindZone(m_zone);
+
+    // 多机同步：主机广播第一个区域的曲目和位置；从机的第一个区域跟随主机，
+    // 换曲由主机决定，从机自己不预排、不续下一首
+    SyncSession::Config syncConfig = SyncSession::loadConfig(QCoreApplication::arguments());
+    if (syncConfig.role != SyncSession::SyncOff) {
+        m_sync = new SyncSession(m_zones.first()->player, syncConfig, this);
+        connect(m_sync, &SyncSession::trackRequested, this,
+                [this](const NetworkManager::SearchItem &item, qint64 startMs) {
+            Zone *z = m_zones.first();
+            z->playlist = QList<NetworkManager::SearchItem>() << item;
+            playIndex(z, 0, startMs);
+        });
+    }
 
 
     // 连接 UI 信号（explicit, 不使用自动槽名）
@@ -59,6 +174,17 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    if (m_dspSaveTimer.isActive()) saveDspPreset();
+    // 扫描和波形线程经由分块缓存读取，必须先于缓存结束
+    delete m_scanner;
+    delete m_waveforms;
+    delete m_beats;
+    delete m_fingerprints;
+    // 播放器经由分块缓存读取，网络线程的下载回调会访问缓存：
+    // 先停播放器，再结束网络线程，缓存最后随窗口析构
+    for (Zone *z : m_zones) delete z->player;
+    qDeleteAll(m_zones);
+    delete m_net;
     delete ui;
 }
 
@@ -75,7 +201,6 @@ void MainWindow::on_btnSearch_clicked()
     ui->statusbar->showMessage("搜索中...");
     ui->listResults->clear();
     m_searchList.clear();
-    m_currentIndex = -1;
 
     m_net->search(kw);
 }
@@ -86,15 +211,7 @@ void MainWindow::onSearchFinished(const QList<NetworkManager::SearchItem> &list)
 {
     ui->statusbar->clearMessage();
     m_searchList = list;
-    ui->listResults->clear();
-
-    for (int i = 0; i < list.size(); ++i) {
-        const auto &it = list.at(i);
-        QListWidgetItem *item = new QListWidgetItem(QString("%1 - %2").arg(it.title, it.singer));
-        item->setData(Qt::UserRole, it.id);       // 存放 id，用于解析真实地址
-        item->setData(Qt::UserRole + 1, i);       // 存放 index
-        ui->listResults->addItem(item);
-    }
+    refreshResultList();
 
     if (list.isEmpty()) {
         ui->statusbar->showMessage("未找到结果", 3000);
@@ -109,19 +226,123 @@ void MainWindow::onSearchFinished(const QList<NetworkManager::SearchItem> &list)
 void MainWindow::on_listResults_itemClicked(QListWidgetItem *item)
 {
     if (!item) return;
-    int id = item->data(Qt::UserRole).toInt();
-    int idx = item->data(Qt::UserRole + 1).toInt();
-    if (idx < 0 || idx >= m_searchList.size()) return;
-
-    m_currentIndex = idx;
-    // 先使用列表中的元数据更新界面
-    setMetadataFromSearchItem(m_searchList.at(idx));
-    // 异步加载封面
-    m_net->fetchImage(m_searchList.at(idx).picurl);
-    // 请求真实播放地址
-    ui->statusbar->showMessage("解析播放地址...");
+
+    // 当前区域改为播放列表里显示的这些歌（按速度筛选/排序后的顺序），整个列表排进响度扫描
+    QList<NetworkManager::SearchItem> playlist;
+    int idx = -1;
+    for (int row = 0; row < ui->listResults->count(); ++row) {
+        QListWidgetItem *rowItem = ui->listResults->item(row);
+        int i = rowItem->data(Qt::UserRole + 1).toInt();
+        if (i < 0 || i >= m_searchList.size()) continue;
+        if (rowItem == item) idx = playlist.size();
+        playlist.append(m_searchList.at(i));
+    }
+    if (idx < 0) return;
+
+    m_zone->playlist = playlist;
+    for (const auto &song : playlist) {
+        m_scanner->enqueue(song.id);
+        m_beats->enqueue(song.id);
+    }
+    playIndex(m_zone, idx);
+}
+
+/*-------------------------------
+ * 按当前速度视图重建列表控件：筛选只影响显示，
+ * 每一项记下它在 m_searchList 中的下标；未分析的歌曲排在最后、不参与筛选。
+ * 声纹判定为同一录音的只保留最先出现的一项：只用已有的声纹，不为列表排队，
+ * 合并是尽力而为（声纹只给收藏、播放过和预排的曲目建立）
+ *------------------------------*/
+void MainWindow::refreshResultList()
+{
+    int view = ui->comboTempo->currentIndex();
+    QList<int> rows;
+    QHash<int, double> bpms;
+    QSet<int> shown;
+    for (int i = 0; i < m_searchList.size(); ++i) {
+        int canonical = m_fingerprints->canonicalId(m_searchList.at(i).id);
+        if (shown.contains(canonical)) continue;
+        shown.insert(canonical);
+
+        if (view == TempoAll) {
+            rows.append(i);
+            continue;
+        }
+        int id = m_searchList.at(i).id;
+        double bpm = BeatAnalyzer::bpm(id);
+        if (bpm <= 0) m_beats->enqueue(id);
+        bpms.insert(i, bpm);
+
+        bool keep = view == TempoSort
+                || (view == TempoSlow && bpm > 0 && bpm < kSlowBpm)
+                || (view == TempoMedium && bpm >= kSlowBpm && bpm <= kFastBpm)
+                || (view == TempoFast && bpm > kFastBpm);
+        if (keep) rows.append(i);
+    }
+    if (view == TempoSort) {
+        std::stable_sort(rows.begin(), rows.end(), [&bpms](int a, int b) {
+            double x = bpms.value(a), y = bpms.value(b);
+            if ((x > 0) != (y > 0)) return x > 0;
+            return x < y;
+        });
+    }
+
+    int current = ui->listResults->currentRow();
+    ui->listResults->clear();
+    for (int i : rows) {
+        const auto &it = m_searchList.at(i);
+        QString text = QString("%1 - %2").arg(it.title, it.singer);
+        double bpm = bpms.value(i);
+        if (bpm > 0) text += QString("  [%1 BPM]").arg(qRound(bpm));
+        QListWidgetItem *item = new QListWidgetItem(text);
+        item->setData(Qt::UserRole, it.id);       // 存放 id，用于解析真实地址
+        item->setData(Qt::UserRole + 1, i);       // 存放 m_searchList 中的下标
+        ui->listResults->addItem(item);
+    }
+    if (current >= 0 && current < ui->listResults->count()) ui->listResults->setCurrentRow(current);
+}
+
+void MainWindow::on_comboTempo_activated(int index)
+{
+    Q_UNUSED(index);
+    refreshResultList();
+}
+
+void MainWindow::playIndex(Zone *z, int index, qint64 startMs)
+{
+    // 手动切歌会替换 mpv 播放列表，之前预排的下一首作废
+    cancelPrefetch(z);
+
+    z->currentIndex = index;
+    z->currentResult = NetworkManager::UrlResult();
+    z->retryCount = 0;
+    const auto &it = z->playlist.at(index);
+    if (z == m_zone) {
+        // 先使用列表中的元数据更新界面
+        setMetadataFromSearchItem(it);
+        // 异步加载封面
+        m_net->fetchImage(it.picurl, ui->labelCover->size());
+        ui->statusbar->showMessage("解析播放地址...");
+    }
+    // 按 id 交给 mpv，真实地址在 mpv 加载时通过 on_load 钩子解析
+    m_scanner->yield(kScanYieldLoadMs);
+    m_waveforms->yield(kScanYieldLoadMs);
+    m_beats->yield(kScanYieldLoadMs);
+    m_fingerprints->yield(kScanYieldLoadMs);
+    z->player->playSong(it.id, startMs);
+    m_fingerprints->enqueue(it.id);
+    if (z == m_zone) updateFavoriteButton();
+    if (m_sync && z == m_zones.first()) m_sync->setTrack(it);
+
+    // 下一首由播放器在当前曲目结束前解析好再排进 mpv，预读照常生效；
+    // 地址在播放中途过期时由分块缓存重新解析
+    schedulePrefetch(z);
+}
+
+void MainWindow::requestUrl(int id, UrlPurpose purpose)
+{
+    m_urlRequests[id].append(purpose);
     m_net->getUrlById(id);
-    updateFavoriteButton();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -129,13 +350,68 @@ void MainWindow::on_listResults_itemClicked(QListWidgetItem *item)
 ///////////////////////////////////////////////////////////////////////////////
 void MainWindow::onGetUrlFinished(const NetworkManager::UrlResult &res)
 {
-    ui->statusbar->clearMessage();
+    UrlPurpose purpose = UrlLoad;
+    auto pending = m_urlRequests.find(res.id);
+    if (pending != m_urlRequests.end()) {
+        purpose = pending->takeFirst();
+        if (pending->isEmpty()) m_urlRequests.erase(pending);
+    }
 
-    if (res.url.isEmpty()) {
-        ui->statusbar->showMessage("解析失败：未获取到播放地址", 4000);
+    if (purpose == UrlScan) {
+        m_scanner->provideSongUrl(res.id, res.url);
         return;
     }
+    if (purpose == UrlWaveform) {
+        m_waveforms->provideSongUrl(res.id, res.url);
+        return;
+    }
+    if (purpose == UrlBeats) {
+        m_beats->provideSongUrl(res.id, res.url);
+        return;
+    }
+    if (purpose == UrlFingerprint) {
+        m_fingerprints->provideSongUrl(res.id, res.url);
+        return;
+    }
+    if (purpose == UrlRefresh) {
+        m_chunkCache->setSource(res.id, res.url);
+        return;
+    }
+
+    // 同一首歌可能在多个区域等待，逐个放行
+    const double gainDb = LoudnessScanner::gainDb(res.id);
+    const TrackTrim trim = WaveformGenerator::trim(res.id);
+    for (Zone *z : m_zones) {
+        // 放行 mpv 的 on_load 钩子；地址为空时 mpv 报错，走断线续播流程
+        z->player->provideSongUrl(res.id, res.url, gainDb,
+                                  z->playMode == PlayCrossfade ? beatAlignedTrim(res.id, trim) : trim);
+
+        bool isCurrent = z->currentIndex >= 0 && z->currentIndex < z->playlist.size()
+                && z->playlist.at(z->currentIndex).id == res.id;
+        bool isQueued = z->prefetchIndex >= 0 && z->prefetchIndex < z->playlist.size()
+                && z->playlist.at(z->prefetchIndex).id == res.id;
+
+        if (isCurrent) {
+            if (res.url.isEmpty()) {
+                if (z == m_zone) ui->statusbar->showMessage("解析失败：未获取到播放地址", 4000);
+                continue;
+            }
+            z->currentResult = res;
+            if (z == m_zone) {
+                // 播放按钮等 mpv 确认后由 stateChanged 更新
+                ui->statusbar->showMessage("缓冲中...", 3000);
+                applyUrlResult(res);
+                updateFavoriteButton();
+            }
+        } else if (isQueued) {
+            // 预排曲目提前解析（无缝/淡入淡出），切过去时再显示歌词
+            z->prefetchResult = res;
+        }
+    }
+}
 
+void MainWindow::applyUrlResult(const NetworkManager::UrlResult &res)
+{
     // 更新元信息（如果接口返回更精确的名称/歌手）
     if (!res.name.isEmpty()) ui->labelTitle->setText(res.name);
     if (!res.artist.isEmpty()) ui->labelArtist->setText(res.artist);
@@ -144,20 +420,16 @@ void MainWindow::onGetUrlFinished(const NetworkManager::UrlResult &res)
     QString lrc = res.lrc;
     lrc.replace("<br />", "\n").replace("<br>", "\n");
     ui->lyricsWidget->setLrcText(lrc.isEmpty() ? QString("无歌词") : lrc);
-
-    // 交给 mpv 播放（直接播放）
-    m_player->playUrl(res.url);
-    updatePlayPauseUI(true);
-    updateFavoriteButton();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 // 图片回调
 ///////////////////////////////////////////////////////////////////////////////
-void MainWindow::onImageFetched(const QPixmap &pix)
+void MainWindow::onImageFetched(const QImage &image)
 {
-    if (!pix.isNull()) {
-        ui->labelCover->setPixmap(pix.scaled(ui->labelCover->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation));
+    if (!image.isNull()) {
+        // 已在网络线程解码并缩放到封面尺寸
+        ui->labelCover->setPixmap(QPixmap::fromImage(image));
     } else {
         ui->labelCover->setPixmap(QPixmap(":/default_cover.png").scaled(ui->labelCover->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation));
     }
@@ -169,27 +441,21 @@ void MainWindow::onImageFetched(const QPixmap &pix)
 void MainWindow::on_btnPlayPause_clicked()
 {
 
-    if (m_player->isPlaying()) {
-        m_player->pause();
+    if (m_zone->player->isPlaying()) {
+        m_zone->player->pause();
     } else {
-        m_player->play();
+        m_zone->player->play();
     }
 }
 
 void MainWindow::on_btnPrev_clicked()
 {
-    if (m_searchList.isEmpty()) return;
-    int n = m_searchList.size();
-    if (m_currentIndex <= 0) m_currentIndex = n - 1;
-    else --m_currentIndex;
+    if (m_zone->playlist.isEmpty()) return;
+    int n = m_zone->playlist.size();
+    int idx = (m_zone->currentIndex <= 0) ? n - 1 : m_zone->currentIndex - 1;
 
     // 模拟列表点击流程
-    const auto &it = m_searchList.at(m_currentIndex);
-    setMetadataFromSearchItem(it);
-    m_net->fetchImage(it.picurl);
-    ui->statusbar->showMessage("解析播放地址...");
-    m_net->getUrlById(it.id);
-    updateFavoriteButton();
+    playIndex(m_zone, idx);
 }
 
 void MainWindow::on_btnNext_clicked()
@@ -204,22 +470,34 @@ void MainWindow::on_btnNext_clicked()
 //    ui->statusbar->showMessage("解析播放地址...");
 //    m_net->getUrlById(it.id);
 //    updateFavoriteButton();
-    playNextByMode();
+    playNextByMode(m_zone);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 // 进度/音量交互
 ///////////////////////////////////////////////////////////////////////////////
+void MainWindow::on_sliderPosition_sliderPressed()
+{
+    m_zone->player->beginScrub();
+}
+
 void MainWindow::on_sliderPosition_sliderMoved(int position)
 {
-    // position 单位为秒（我们把 slider 的值当作秒）
+    // position 单位为秒（我们把 slider 的值当作秒）；拖动中由 MPVPlayer 合并为关键帧 seek
     qint64 ms = qint64(position) * 1000;
-    m_player->setPosition(ms);
+    m_zone->player->scrubTo(ms);
+}
+
+void MainWindow::on_sliderPosition_sliderReleased()
+{
+    // 松手时做一次精确 seek
+    m_zone->player->endScrub(qint64(ui->sliderPosition->value()) * 1000);
 }
 
 void MainWindow::on_sliderVolume_valueChanged(int value)
 {
-    m_player->setVolume(value);
+    m_zone->volume = value;
+    m_zone->player->setVolume(value);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -230,8 +508,10 @@ void MainWindow::onPositionChanged(qint64 ms)
     // 更新进度显示与 slider（防止在用户拖动时干扰）
     if (!ui->sliderPosition->isSliderDown()) {
         qint64 sec = ms / 1000;
-        ui->labelProgress->setText(secondsToString(ms));
-        ui->lyricsWidget->updatePosition(ms);
+        // 播放中由帧定时器按插值时钟刷新文字和歌词，这里只处理暂停/seek 时的跳变
+        if (!m_frameTimer.isActive()) {
+            updateProgressText(ms);
+        }
         ui->sliderPosition->blockSignals(true);
         ui->sliderPosition->setValue((int)sec);
         ui->sliderPosition->blockSignals(false);
@@ -243,11 +523,28 @@ void MainWindow::onDurationChanged(qint64 ms)
     qint64 sec = ms / 1000;
     ui->labelDuration->setText(secondsToString(ms));
     ui->sliderPosition->setRange(0, (int)sec);
+    ui->sliderPosition->setDurationMs(ms);
 }
 
 void MainWindow::onPlayerStateChanged(bool playing)
 {
     updatePlayPauseUI(playing);
+    if (playing) m_frameTimer.start();
+    else m_frameTimer.stop();
+    if (playing) ui->statusbar->clearMessage();
+}
+
+void MainWindow::onFrameTick()
+{
+    qint64 ms = m_zone->player->positionMs();
+    if (ms < 0 || ui->sliderPosition->isSliderDown()) return;
+    updateProgressText(ms);
+}
+
+void MainWindow::onPlayerRequestFailed(quint64 requestId, int mpvError, const QString &message)
+{
+    Q_UNUSED(requestId)
+    ui->statusbar->showMessage(QString("播放器错误：%1（%2）").arg(message).arg(mpvError), 4000);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -257,6 +554,15 @@ void MainWindow::setMetadataFromSearchItem(const NetworkManager::SearchItem &it)
 {
     ui->labelTitle->setText(it.title.isEmpty() ? "未选择" : it.title);
     ui->labelArtist->setText(it.singer);
+    showWaveform(it.id);
+}
+
+void MainWindow::showWaveform(int songId)
+{
+    if (songId == m_waveformSongId) return;
+    m_waveformSongId = songId;
+    ui->sliderPosition->clearWaveform();
+    m_waveforms->request(songId);
 }
 
 void MainWindow::updatePlayPauseUI(bool playing)
@@ -273,6 +579,18 @@ void MainWindow::resetMetadataDisplay()
     ui->labelProgress->setText("0 s");
     ui->labelDuration->setText("0 s");
     ui->sliderPosition->setRange(0, 0);
+    m_waveformSongId = 0;
+    ui->sliderPosition->clearWaveform();
+}
+
+void MainWindow::updateProgressText(qint64 ms)
+{
+    QString text = secondsToString(ms);
+    // 秒数不变时不重设文字，避免每帧触发 QLabel 重新布局
+    if (ui->labelProgress->text() != text) {
+        ui->labelProgress->setText(text);
+    }
+    ui->lyricsWidget->updatePosition(ms);
 }
 
 QString MainWindow::secondsToString(qint64 ms)
@@ -291,12 +609,12 @@ void MainWindow::addToFavorites(const NetworkManager::SearchItem &item)
     st.beginGroup("Favorites");
     int count = st.value("count", 0).toInt();
 
-    // 防止重复收藏
+    // 防止重复收藏（声纹判定为同一录音的其他 id 也算）
     for (int i = 0; i < count; ++i) {
         st.beginGroup(QString::number(i));
         int id = st.value("id").toInt();
         st.endGroup();
-        if (id == item.id) {
+        if (m_fingerprints->canonicalId(id) == m_fingerprints->canonicalId(item.id)) {
             ui->statusbar->showMessage("已在收藏中", 2000);
             st.endGroup();
             return;
@@ -314,6 +632,9 @@ void MainWindow::addToFavorites(const NetworkManager::SearchItem &item)
     st.setValue("count", count + 1);
     st.endGroup();
 
+    m_scanner->enqueue(item.id);
+    m_beats->enqueue(item.id);
+    m_fingerprints->enqueue(item.id);
     ui->statusbar->showMessage("已加入收藏", 2000);
 }
 
@@ -330,7 +651,7 @@ bool MainWindow::isFavorited(int songId) const
         int id = st.value("id").toInt();
         st.endGroup();
 
-        if (id == songId) {
+        if (m_fingerprints->canonicalId(id) == m_fingerprints->canonicalId(songId)) {
             st.endGroup();
             return true;
         }
@@ -340,6 +661,23 @@ bool MainWindow::isFavorited(int songId) const
     return false;
 }
 
+QList<int> MainWindow::favoriteIds() const
+{
+    QSettings st("favorites.ini", QSettings::IniFormat);
+    st.setIniCodec("UTF-8");
+
+    QList<int> ids;
+    st.beginGroup("Favorites");
+    int count = st.value("count", 0).toInt();
+    for (int i = 0; i < count; ++i) {
+        st.beginGroup(QString::number(i));
+        ids.append(st.value("id").toInt());
+        st.endGroup();
+    }
+    st.endGroup();
+    return ids;
+}
+
 void MainWindow::removeFromFavorites(int songId)
 {
     QSettings st("favorites.ini", QSettings::IniFormat);
@@ -354,7 +692,7 @@ void MainWindow::removeFromFavorites(int songId)
         st.beginGroup(QString::number(i));
         int id = st.value("id").toInt();
 
-        if (id != songId) {
+        if (m_fingerprints->canonicalId(id) != m_fingerprints->canonicalId(songId)) {
             QVariantMap m;
             m["id"] = id;
             m["title"] = st.value("title");
@@ -386,12 +724,12 @@ void MainWindow::removeFromFavorites(int songId)
 
 void MainWindow::updateFavoriteButton()
 {
-    if (m_currentIndex < 0 || m_currentIndex >= m_searchList.size()) {
+    if (m_zone->currentIndex < 0 || m_zone->currentIndex >= m_zone->playlist.size()) {
         ui->collect_btn->setIcon(QIcon(":/image/res/heart_gray.png"));
         return;
     }
 
-    int id = m_searchList.at(m_currentIndex).id;
+    int id = m_zone->playlist.at(m_zone->currentIndex).id;
 
     if (isFavorited(id)) {
         ui->collect_btn->setIcon(QIcon(":/image/res/heart_red.png"));
@@ -402,7 +740,7 @@ void MainWindow::updateFavoriteButton()
 
 void MainWindow::updatePlayModeButton()
 {
-    switch (m_playMode) {
+    switch (m_zone->playMode) {
     case PlaySequence:
         ui->mode_btn->setIcon(QIcon(":/image/res/mode_sequence.png"));
         break;
@@ -412,28 +750,40 @@ void MainWindow::updatePlayModeButton()
     case PlaySingleLoop:
         ui->mode_btn->setIcon(QIcon(":/image/res/mode_single.png"));
         break;
+    case PlayCrossfade:
+        // 淡入淡出本质是顺序播放，沿用顺序图标
+        ui->mode_btn->setIcon(QIcon(":/image/res/mode_sequence.png"));
+        break;
     }
+    ui->mode_btn->setToolTip(m_zone->playMode == PlayCrossfade ? "淡入淡出" : QString());
 }
 
-void MainWindow::playNextByMode()
+void MainWindow::playNextByMode(Zone *z)
 {
-    if (m_searchList.isEmpty()) return;
+    if (z->playlist.isEmpty() || isSyncFollower(z)) return;
 
-    int n = m_searchList.size();
+    // 已经选好的预排曲目优先（随机模式下保持和预读的一致）
+    int idx = z->prefetchIndex >= 0 ? z->prefetchIndex : pickNextIndex(z);
+    playIndex(z, idx);
+}
+
+int MainWindow::pickNextIndex(const Zone *z) const
+{
+    int n = z->playlist.size();
+    int index = z->currentIndex;
 
-    switch (m_playMode) {
+    switch (z->playMode) {
 
     case PlaySequence:
-        m_currentIndex = (m_currentIndex + 1) % n;
+    case PlayCrossfade:
+        index = (z->currentIndex + 1) % n;
         break;
 
     case PlayRandom:
         if (n > 1) {
-            int newIndex;
             do {
-                newIndex = QRandomGenerator::global()->bounded(n);
-            } while (newIndex == m_currentIndex);
-            m_currentIndex = newIndex;
+                index = QRandomGenerator::global()->bounded(n);
+            } while (index == z->currentIndex);
         }
         break;
 
@@ -442,11 +792,62 @@ void MainWindow::playNextByMode()
         break;
     }
 
-    const auto &it = m_searchList.at(m_currentIndex);
-    setMetadataFromSearchItem(it);
-    m_net->fetchImage(it.picurl);
-    ui->statusbar->showMessage("解析播放地址...");
-    m_net->getUrlById(it.id);
+    if (index < 0) index = 0;
+    return index;
+}
+
+void MainWindow::schedulePrefetch(Zone *z)
+{
+    cancelPrefetch(z);
+    if (z->playlist.isEmpty() || z->currentIndex < 0 || isSyncFollower(z)) return;
+
+    z->prefetchIndex = pickNextIndex(z);
+    z->prefetchQueued = true;
+    // 下一首优先扫描和分析，赶在切过去之前拿到增益和静音裁剪点
+    m_scanner->enqueue(z->playlist.at(z->prefetchIndex).id, true);
+    m_beats->enqueue(z->playlist.at(z->prefetchIndex).id, true);
+    m_waveforms->enqueue(z->playlist.at(z->prefetchIndex).id);
+    m_fingerprints->enqueue(z->playlist.at(z->prefetchIndex).id);
+    z->player->queueNextSong(z->playlist.at(z->prefetchIndex).id);
+}
+
+void MainWindow::cancelPrefetch(Zone *z)
+{
+    z->prefetchIndex = -1;
+    z->prefetchQueued = false;
+    z->prefetchResult = NetworkManager::UrlResult();
+    z->player->clearQueue();
+}
+
+/*-------------------------------
+ * 淡入淡出对拍：淡出从本曲的某一拍开始（终点 = 该拍 + 淡变时长），
+ * 淡入的曲目从它的第一拍开始，两首的拍子在衔接处重合。
+ * 只挪动已有的静音裁剪点附近不超过 kMaxBeatSnapMs 的距离
+ *------------------------------*/
+TrackTrim MainWindow::beatAlignedTrim(int songId, const TrackTrim &trim) const
+{
+    BeatGrid grid;
+    if (!BeatAnalyzer::load(songId, grid) || grid.confidence < kMinBeatConfidence) return trim;
+
+    QSettings st("settings.ini", QSettings::IniFormat);
+    qint64 fadeMs = qint64(st.value("Playback/crossfadeSec", 6.0).toDouble() * 1000);
+    TrackTrim aligned = trim;
+
+    for (qint64 beat : grid.beatsMs) {
+        if (beat < trim.startMs) continue;
+        if (beat - trim.startMs <= kMaxBeatSnapMs) aligned.startMs = beat;
+        break;
+    }
+
+    qint64 endMs = trim.endMs > 0 ? trim.endMs : grid.durationMs;
+    qint64 fadeStartMs = endMs - qMin(fadeMs, endMs / 2);
+    for (int i = grid.beatsMs.size() - 1; i >= 0; --i) {
+        qint64 beat = grid.beatsMs.at(i);
+        if (beat > fadeStartMs) continue;
+        if (fadeStartMs - beat <= kMaxBeatSnapMs) aligned.endMs = beat + (endMs - fadeStartMs);
+        break;
+    }
+    return aligned;
 }
 
 
@@ -455,7 +856,6 @@ void MainWindow::on_host_btn_clicked()
     ui->statusbar->showMessage("加载中...");
     ui->listResults->clear();
     m_searchList.clear();
-    m_currentIndex = -1;
 
     m_net->getHost();
 }
@@ -465,7 +865,6 @@ void MainWindow::on_new_btn_clicked()
     ui->statusbar->showMessage("加载中...");
     ui->listResults->clear();
     m_searchList.clear();
-    m_currentIndex = -1;
 
     m_net->getNew();
 }
@@ -474,7 +873,6 @@ void MainWindow::on_love_btn_clicked()
 {
     ui->listResults->clear();
     m_searchList.clear();
-    m_currentIndex = -1;
 
     QSettings st("favorites.ini", QSettings::IniFormat);
     st.setIniCodec("UTF-8");
@@ -494,27 +892,22 @@ void MainWindow::on_love_btn_clicked()
         st.endGroup();
 
         m_searchList.append(it);
-
-        QListWidgetItem *item =
-            new QListWidgetItem(QString("%1 - %2").arg(it.title, it.singer));
-        item->setData(Qt::UserRole, it.id);
-        item->setData(Qt::UserRole + 1, i);
-        ui->listResults->addItem(item);
     }
 
     st.endGroup();
+    refreshResultList();
 
     ui->statusbar->showMessage(QString("收藏 %1 首").arg(count), 3000);
 }
 
 void MainWindow::on_collect_btn_clicked()
 {
-    if (m_currentIndex < 0 || m_currentIndex >= m_searchList.size()) {
+    if (m_zone->currentIndex < 0 || m_zone->currentIndex >= m_zone->playlist.size()) {
             ui->statusbar->showMessage("没有正在播放的歌曲", 2000);
             return;
         }
 
-        const auto &item = m_searchList.at(m_currentIndex);
+        const auto &item = m_zone->playlist.at(m_zone->currentIndex);
 
         if (isFavorited(item.id)) {
             removeFromFavorites(item.id);
@@ -528,27 +921,321 @@ void MainWindow::on_collect_btn_clicked()
 
 void MainWindow::on_mode_btn_clicked()
 {
-    switch (m_playMode) {
+    switch (m_zone->playMode) {
         case PlaySequence:
-            m_playMode = PlayRandom;
+            m_zone->playMode = PlayRandom;
             ui->statusbar->showMessage("随机播放", 2000);
             break;
 
         case PlayRandom:
-            m_playMode = PlaySingleLoop;
+            m_zone->playMode = PlaySingleLoop;
             ui->statusbar->showMessage("单曲循环", 2000);
             break;
 
         case PlaySingleLoop:
-            m_playMode = PlaySequence;
+            m_zone->playMode = PlayCrossfade;
+            ui->statusbar->showMessage("淡入淡出", 2000);
+            break;
+
+        case PlayCrossfade:
+            m_zone->playMode = PlaySequence;
             ui->statusbar->showMessage("顺序播放", 2000);
             break;
         }
 
         updatePlayModeButton();
+
+        // 淡入淡出时长可在 settings.ini 中配置
+        QSettings st("settings.ini", QSettings::IniFormat);
+        double fadeSec = st.value("Playback/crossfadeSec", 6.0).toDouble();
+        m_zone->player->setCrossfade(m_zone->playMode == PlayCrossfade ? fadeSec : 0.0);
+
+        // 下一首随模式变化，重新预排
+        schedulePrefetch(m_zone);
+}
+
+void MainWindow::onTrackAdvanced(Zone *z)
+{
+    // mpv 已经在播预排的曲目，这里只同步状态和界面
+    if (!z->prefetchQueued || z->prefetchIndex < 0 || z->prefetchIndex >= z->playlist.size()) return;
+
+    z->currentIndex = z->prefetchIndex;
+    z->retryCount = 0;
+    NetworkManager::UrlResult res = z->prefetchResult;
+    z->prefetchIndex = -1;
+    z->prefetchQueued = false;
+
+    const auto &it = z->playlist.at(z->currentIndex);
+    if (m_sync && z == m_zones.first()) m_sync->setTrack(it);
+    // 钩子解析可能还没回来，回来后在 onGetUrlFinished 里补上歌词
+    z->currentResult = res.id == it.id ? res : NetworkManager::UrlResult();
+    if (z == m_zone) {
+        setMetadataFromSearchItem(it);
+        m_net->fetchImage(it.picurl, ui->labelCover->size());
+        if (res.id == it.id) applyUrlResult(res);
+        else ui->lyricsWidget->setLrcText("无歌词");
+        updateFavoriteButton();
+    }
+
+    schedulePrefetch(z);
+}
+
+bool MainWindow::isSyncFollower(const Zone *z) const
+{
+    return m_sync && m_sync->isFollower() && z == m_zones.first();
+}
+
+/*-------------------------------
+ * 断线续播：按 id 从断点处重新加载，on_load 钩子会重新解析地址
+ * （旧地址可能已过期），指数退避，次数有限
+ *------------------------------*/
+void MainWindow::onStreamFailed(Zone *z, qint64 resumeMs, bool stalled)
+{
+    if (z->currentIndex < 0 || z->currentIndex >= z->playlist.size()) return;
+
+    if (z->retryCount >= kMaxStreamRetries) {
+        if (z == m_zone) ui->statusbar->showMessage("网络异常，播放已中断", 4000);
+        return;
+    }
+
+    int delay = kRetryBaseDelayMs << z->retryCount;
+    ++z->retryCount;
+    // 重连期间网络优先给续播
+    m_scanner->yield(delay + kScanYieldLoadMs);
+    m_waveforms->yield(delay + kScanYieldLoadMs);
+    m_beats->yield(delay + kScanYieldLoadMs);
+    m_fingerprints->yield(delay + kScanYieldLoadMs);
+    z->resumeMs = resumeMs;
+    if (z == m_zone) {
+        ui->statusbar->showMessage(QString("%1，正在重连（%2/%3）...")
+                                   .arg(stalled ? "缓冲超时" : "网络中断")
+                                   .arg(z->retryCount).arg(kMaxStreamRetries));
+    }
+
+    int id = z->playlist.at(z->currentIndex).id;
+    QTimer::singleShot(delay, this, [this, z, id]() {
+        // 等待期间换了歌就不再续播
+        if (z->currentIndex < 0 || z->currentIndex >= z->playlist.size()
+                || z->playlist.at(z->currentIndex).id != id) {
+            return;
+        }
+        if (z == m_zone) ui->statusbar->showMessage("正在重新连接...", 3000);
+        z->player->playSong(id, z->resumeMs);
+        // replace 清掉了 mpv 里预排的下一首，重新排
+        schedulePrefetch(z);
+    });
+}
+
+/*-------------------------------
+ * 音频输出：设备列表随热插拔刷新，选择与低延迟开关保存在 settings.ini
+ *------------------------------*/
+void MainWindow::onAudioDevicesChanged(const QList<MpvAudioDevice> &devices)
+{
+    // 热插拔时整表刷新，保持当前选择
+    QString current = m_zone->player->audioDevice();
+    if (current.isEmpty()) current = "auto";
+
+    ui->comboDevice->clear();
+    for (const MpvAudioDevice &dev : devices) {
+        QString text = dev.description.isEmpty() ? dev.name : dev.description;
+        ui->comboDevice->addItem(text, dev.name);
+    }
+    int idx = ui->comboDevice->findData(current);
+    if (idx >= 0) ui->comboDevice->setCurrentIndex(idx);
+}
+
+void MainWindow::on_comboDevice_activated(int index)
+{
+    QString name = ui->comboDevice->itemData(index).toString();
+    if (name.isEmpty() || name == m_zone->player->audioDevice()) return;
+
+    // 换设备前先把上一个设备的预设写掉
+    if (m_dspSaveTimer.isActive()) {
+        m_dspSaveTimer.stop();
+        saveDspPreset();
+    }
+    m_zone->player->setAudioDevice(name);
+    QSettings st("settings.ini", QSettings::IniFormat);
+    st.setValue(zoneSettingsKey(m_zones.indexOf(m_zone), "device"), name);
+
+    // 音效预设跟随输出设备
+    m_zone->player->setDsp(loadDspPreset(name));
+    if (m_dspDialog) m_dspDialog->setSettings(m_zone->player->dsp());
+}
+
+void MainWindow::on_checkLowLatency_toggled(bool checked)
+{
+    m_zone->player->setLowLatency(checked);
+    QSettings st("settings.ini", QSettings::IniFormat);
+    st.setValue(zoneSettingsKey(m_zones.indexOf(m_zone), "lowLatency"), checked);
+}
+
+/*-------------------------------
+ * 播放区域：每个区域一个 MPVPlayer，队列推进/续播/地址解析对所有区域生效，
+ * 进度、歌词等界面信号只连接当前区域
+ *------------------------------*/
+MainWindow::Zone *MainWindow::createZone(int index)
+{
+    Zone *z = new Zone;
+    QSettings st("settings.ini", QSettings::IniFormat);
+
+    // 独立音频进程模式：界面卡死/崩溃不影响出声，引擎自带网络和分块缓存
+    if (st.value("Engine/outOfProcess", false).toBool()) {
+        RemotePlayer *remote = new RemotePlayer(engineServerName(index), this);
+        remote->setStopEngineOnExit(st.value("Engine/stopWithGui", false).toBool());
+        z->player = remote;
+    } else {
+        MPVPlayer *player = new MPVPlayer(this);
+        player->setChunkCache(m_chunkCache);
+        z->player = player;
+    }
+
+    // 恢复上次的输出设备与低延迟开关
+    QString device = st.value(zoneSettingsKey(index, "device")).toString();
+    if (!device.isEmpty()) z->player->setAudioDevice(device);
+    z->player->setLowLatency(st.value(zoneSettingsKey(index, "lowLatency"), false).toBool());
+    z->player->setDsp(loadDspPreset(device));
+    z->player->setVolume(z->volume);
+
+    connect(z->player, &AudioPlayer::playbackFinished, this, [this, z]() { playNextByMode(z); });
+    connect(z->player, &AudioPlayer::trackAdvanced, this, [this, z]() { onTrackAdvanced(z); });
+    connect(z->player, &AudioPlayer::streamFailed, this, [this, z](qint64 resumeMs, bool stalled) {
+        onStreamFailed(z, resumeMs, stalled);
+    });
+    connect(z->player, &AudioPlayer::songUrlRequested, this, [this](int songId) {
+        requestUrl(songId, UrlLoad);
+    });
+    connect(z->player, &AudioPlayer::firstAudio, this, [this]() {
+        m_scanner->yield(kScanYieldAfterStartMs);
+        m_waveforms->yield(kScanYieldAfterStartMs);
+        m_beats->yield(kScanYieldAfterStartMs);
+        m_fingerprints->yield(kScanYieldAfterStartMs);
+    });
+    return z;
+}
+
+void MainWindow::bindZone(Zone *z)
+{
+    for (const QMetaObject::Connection &c : m_zoneConnections) disconnect(c);
+    m_zoneConnections.clear();
+    // 电平表只显示当前区域，其他区域不需要测量
+    if (m_zone && m_zone != z) m_zone->player->setMetering(false);
+    m_zone = z;
+
+    AudioPlayer *p = z->player;
+    m_zoneConnections << connect(p, &AudioPlayer::positionChanged, this, &MainWindow::onPositionChanged);
+    m_zoneConnections << connect(p, &AudioPlayer::durationChanged, this, &MainWindow::onDurationChanged);
+    m_zoneConnections << connect(p, &AudioPlayer::stateChanged, this, &MainWindow::onPlayerStateChanged);
+    m_zoneConnections << connect(p, &AudioPlayer::requestFailed, this, &MainWindow::onPlayerRequestFailed);
+    m_zoneConnections << connect(p, &AudioPlayer::bufferedRangesChanged, ui->sliderPosition, &SeekSlider::setBufferedRanges);
+    m_zoneConnections << connect(p, &AudioPlayer::seekWillStall, this, [this](qint64, qint64 expectedStallMs) {
+        if (expectedStallMs >= 0)
+            ui->statusbar->showMessage(QString("该位置尚未缓存，预计等待 %1 ms").arg(expectedStallMs), 2000);
+        else
+            ui->statusbar->showMessage("该位置尚未缓存，需要重新下载", 2000);
+    });
+    // 拖动中的关键帧 seek 很频繁，只显示松手后那次精确 seek 的耗时
+    m_zoneConnections << connect(p, &AudioPlayer::seekCompleted, this, [this](qint64 latencyMs, bool exact) {
+        if (exact) ui->statusbar->showMessage(QString("跳转耗时 %1 ms").arg(latencyMs), 2000);
+    });
+    m_zoneConnections << connect(p, &AudioPlayer::firstAudio, this, [this](qint64 latencyMs) {
+        ui->statusbar->showMessage(QString("起播耗时 %1 ms").arg(latencyMs), 2000);
+    });
+    m_zoneConnections << connect(p, &AudioPlayer::outputLatencyMeasured, this, [this](qint64 latencyMs) {
+        ui->statusbar->showMessage(QString("输出延迟 %1 ms").arg(latencyMs), 2000);
+    });
+    m_zoneConnections << connect(p, &AudioPlayer::audioDevicesChanged, this, &MainWindow::onAudioDevicesChanged);
+    m_zoneConnections << connect(p, &AudioPlayer::levelsChanged, ui->meterWidget, &MeterWidget::setLevels);
+
+    // 界面恢复到该区域的状态
+    {
+        QSignalBlocker volumeBlocker(ui->sliderVolume);
+        ui->sliderVolume->setValue(z->volume);
+        QSignalBlocker latencyBlocker(ui->checkLowLatency);
+        ui->checkLowLatency->setChecked(p->isLowLatency());
+    }
+    onAudioDevicesChanged(p->audioDevices());
+    updatePlayModeButton();
+    if (m_dspDialog) m_dspDialog->setSettings(p->dsp());
+    ui->meterWidget->reset();
+    p->setMetering(ui->meterWidget->isVisible());
+
+    if (z->currentIndex >= 0 && z->currentIndex < z->playlist.size()) {
+        const auto &it = z->playlist.at(z->currentIndex);
+        setMetadataFromSearchItem(it);
+        m_net->fetchImage(it.picurl, ui->labelCover->size());
+        if (z->currentResult.id == it.id) applyUrlResult(z->currentResult);
+        else ui->lyricsWidget->setLrcText("无歌词");
+    } else {
+        resetMetadataDisplay();
+        ui->lyricsWidget->setLrcText("无歌词");
+    }
+    onDurationChanged(p->durationMs());
+    onPositionChanged(qMax<qint64>(0, p->positionMs()));
+    updateProgressText(qMax<qint64>(0, p->positionMs()));
+    ui->sliderPosition->setBufferedRanges(p->bufferedRanges());
+    onPlayerStateChanged(p->isPlaying());
+    updateFavoriteButton();
+}
+
+QString MainWindow::zoneSettingsKey(int zoneIndex, const QString &key) const
+{
+    // 第一个区域沿用原来的 Audio 分组
+    if (zoneIndex <= 0) return "Audio/" + key;
+    return QString("Zone%1/%2").arg(zoneIndex + 1).arg(key);
+}
+
+void MainWindow::on_comboZone_activated(int index)
+{
+    if (index < 0 || index >= m_zones.size() || m_zones.at(index) == m_zone) return;
+    if (ui->sliderPosition->isSliderDown()) m_zone->player->endScrub(qint64(ui->sliderPosition->value()) * 1000);
+    bindZone(m_zones.at(index));
+}
+
+/*-------------------------------
+ * 音效：调节窗口的每次改动直接交给当前区域（播放器内部走 af-command），
+ * 预设按输出设备保存在 settings.ini 的 DspPresets 分组
+ *------------------------------*/
+void MainWindow::on_dsp_btn_clicked()
+{
+    if (!m_dspDialog) {
+        m_dspDialog = new EqualizerDialog(this);
+        connect(m_dspDialog, &EqualizerDialog::settingsChanged, this, &MainWindow::onDspChanged);
+    }
+    m_dspDialog->setSettings(m_zone->player->dsp());
+    m_dspDialog->show();
+    m_dspDialog->raise();
+}
+
+void MainWindow::onDspChanged(const DspSettings &dsp)
+{
+    // 切换区域前未写的预设先落盘
+    if (m_dspSaveTimer.isActive() && m_dspSaveZone != m_zone) saveDspPreset();
+
+    m_zone->player->setDsp(dsp);
+    m_dspSaveZone = m_zone;
+    m_dspSaveTimer.start();
+}
+
+void MainWindow::saveDspPreset()
+{
+    Zone *z = m_dspSaveZone;
+    m_dspSaveZone = nullptr;
+    if (!z) return;
+
+    QSettings st("settings.ini", QSettings::IniFormat);
+    st.setValue(dspPresetKey(z->player->audioDevice()), z->player->dsp().toVariant());
+}
+
+DspSettings MainWindow::loadDspPreset(const QString &device) const
+{
+    QSettings st("settings.ini", QSettings::IniFormat);
+    return DspSettings::fromVariant(st.value(dspPresetKey(device)).toMap());
 }
 
-void MainWindow::onPlaybackFinished()
+QString MainWindow::dspPresetKey(const QString &device) const
 {
-    playNextByMode();
+    // 设备名里常有 '/'（如 pulse/alsa_output...），转义后作为键名
+    QString name = device.isEmpty() ? QString("auto") : device;
+    return "DspPresets/" + QString::fromLatin1(QUrl::toPercentEncoding(name));
 }
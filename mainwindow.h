@@ -9,9 +9,20 @@
 
 #include <QMainWindow>
 #include <QList>
+#include <QHash>
+#include <QVector>
 #include <QListWidgetItem>
+#include <QTimer>
 #include "networkmanager.h"
 #include "mpvplayer.h"
+#include "remoteplayer.h"
+#include "audiochunkcache.h"
+#include "loudnessscanner.h"
+#include "waveformgenerator.h"
+#include "beatanalyzer.h"
+#include "fingerprintindex.h"
+#include "syncsession.h"
+#include "equalizerdialog.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -32,18 +43,26 @@ private slots:
     void on_btnPlayPause_clicked();
     void on_btnPrev_clicked();
     void on_btnNext_clicked();
+    void on_sliderPosition_sliderPressed();
     void on_sliderPosition_sliderMoved(int position); // 用户拖动进度条（秒）
+    void on_sliderPosition_sliderReleased();
     void on_sliderVolume_valueChanged(int value);
+    void on_comboDevice_activated(int index);
+    void on_checkLowLatency_toggled(bool checked);
+    void on_comboZone_activated(int index);
+    void on_comboTempo_activated(int index);
+    void on_dsp_btn_clicked();
 
     // NetworkManager 信号
     void onSearchFinished(const QList<NetworkManager::SearchItem> &list);
     void onGetUrlFinished(const NetworkManager::UrlResult &res);
-    void onImageFetched(const QPixmap &pix);
+    void onImageFetched(const QImage &image);
 
     // MPVPlayer 信号
     void onPositionChanged(qint64 ms);
     void onDurationChanged(qint64 ms);
     void onPlayerStateChanged(bool playing);
+    void onPlayerRequestFailed(quint64 requestId, int mpvError, const QString &message);
     void on_host_btn_clicked();
 
     void on_new_btn_clicked();
@@ -54,28 +73,105 @@ private slots:
 
     void on_mode_btn_clicked();
 
-    void onPlaybackFinished();
+    void onFrameTick(); // 按帧率读取播放时钟，刷新歌词与进度文字
+    void onAudioDevicesChanged(const QList<MpvAudioDevice> &devices);
 private:
+    /*
+     * 播放区域（房间）：各自的 mpv 内核、播放列表、预排、音量和输出设备。
+     * 所有区域共用网络、分块缓存和 mpv 事件线程；界面同一时间只控制其中一个。
+     */
+    struct Zone {
+        AudioPlayer *player = nullptr;             // 进程内 MPVPlayer 或独立音频进程的代理
+        QList<NetworkManager::SearchItem> playlist; // 点歌时从当前列表拷贝，换列表不影响正在播的
+        int currentIndex = -1;                      // 在 playlist 中的索引，-1 表示无
+        NetworkManager::UrlResult currentResult;    // 当前曲目的解析结果（切回该区域时恢复歌词）
+        PlayMode playMode = PlaySequence;
+        int volume = 80;
+
+        // 预排的下一首：按 id 排进 mpv，索引提前确定（随机模式下只抽一次）
+        int prefetchIndex = -1;                     // -1 表示无
+        bool prefetchQueued = false;                // 已交给 mpv 排队
+        NetworkManager::UrlResult prefetchResult;   // 钩子提前解析到的元信息（歌词等）
+
+        // 断线续播：每首歌最多重试若干次，换歌时清零
+        int retryCount = 0;
+        qint64 resumeMs = 0;
+    };
+
     Ui::MainWindow *ui;
     NetworkManager *m_net;
-    MPVPlayer *m_player;
-    PlayMode m_playMode;   // 当前播放模式
-
-    QList<NetworkManager::SearchItem> m_searchList;
-    int m_currentIndex; // 当前播放索引（在 m_searchList 中），-1 表示无
+    AudioChunkCache *m_chunkCache; // 音频分块缓存，所有区域共用
+    LoudnessScanner *m_scanner;    // 后台响度扫描（收藏和播放列表）
+    WaveformGenerator *m_waveforms; // 进度条波形概览
+    int m_waveformSongId;          // 进度条应显示哪首歌的波形
+    BeatAnalyzer *m_beats;         // 节拍分析（淡入淡出对拍、按速度筛选）
+    QTimer m_listRefreshTimer;     // 节拍结果陆续到达时合并刷新列表
+    FingerprintIndex *m_fingerprints; // 声纹去重（列表合并重复项、收藏按同一录音判断）
+    QVector<Zone *> m_zones;
+    Zone *m_zone;                  // 界面当前控制的区域
+    QList<QMetaObject::Connection> m_zoneConnections; // 只对当前区域生效的界面连接
+    QTimer m_frameTimer;   // 仅在播放时运行
+    EqualizerDialog *m_dspDialog;  // 首次打开时创建
+    QTimer m_dspSaveTimer;         // 拖动结束后再写预设，避免每步都写文件
+    Zone *m_dspSaveZone;
+    SyncSession *m_sync;           // 多机同步（只作用于第一个区域），未启用时为空
+
+    QList<NetworkManager::SearchItem> m_searchList; // 列表控件中显示的歌曲（筛选/排序前）
+
+    // 列表的速度视图，与 comboTempo 的选项顺序一致
+    enum TempoView {
+        TempoAll,
+        TempoSort,
+        TempoSlow,
+        TempoMedium,
+        TempoFast
+    };
+
+    // 播放地址解析请求的用途（同一 id 可能同时有多个请求，按发出顺序排队）
+    enum UrlPurpose {
+        UrlLoad,      // mpv on_load 钩子等待的地址（播放/预排/续播都走这里）
+        UrlScan,      // 响度扫描即将开始的曲目
+        UrlWaveform,  // 波形生成即将开始的曲目
+        UrlBeats,     // 节拍分析即将开始的曲目
+        UrlFingerprint, // 声纹提取即将开始的曲目
+        UrlRefresh    // 分块缓存里的地址过期，换新地址继续下载
+    };
+    QHash<int, QList<UrlPurpose>> m_urlRequests;
 
     void setMetadataFromSearchItem(const NetworkManager::SearchItem &it);
     void updatePlayPauseUI(bool playing);
     void resetMetadataDisplay();
+    void showWaveform(int songId);
+    void refreshResultList();
+    TrackTrim beatAlignedTrim(int songId, const TrackTrim &trim) const;
     QString secondsToString(qint64 ms);
+    void updateProgressText(qint64 ms);
     void addToFavorites(const NetworkManager::SearchItem &item);
     bool isFavorited(int songId) const;
+    QList<int> favoriteIds() const;
     void removeFromFavorites(int songId);
     void updateFavoriteButton();
 
 
     void updatePlayModeButton();
-    void playNextByMode();
+    void playNextByMode(Zone *z);
+    int pickNextIndex(const Zone *z) const;
+    void playIndex(Zone *z, int index, qint64 startMs = -1);
+    void requestUrl(int id, UrlPurpose purpose);
+    void schedulePrefetch(Zone *z);
+    void cancelPrefetch(Zone *z);
+    void applyUrlResult(const NetworkManager::UrlResult &res);
+
+    Zone *createZone(int index);
+    void bindZone(Zone *z);
+    QString zoneSettingsKey(int zoneIndex, const QString &key) const;
+    void onTrackAdvanced(Zone *z);
+    void onStreamFailed(Zone *z, qint64 resumeMs, bool stalled);
+    bool isSyncFollower(const Zone *z) const;
+    void onDspChanged(const DspSettings &dsp);
+    void saveDspPreset();
+    DspSettings loadDspPreset(const QString &device) const;
+    QString dspPresetKey(const QString &device) const;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,198 @@
+/**
+ * @brief   : 电平表组件实现
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#include "meterwidget.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QLinearGradient>
+
+// 显示范围（dBFS），低于下限的不画
+static const double kDisplayFloorDb = -60.0;
+// 渐变由绿转黄的位置（dBFS）
+static const double kWarnDb = -12.0;
+// 下落速度（dB/秒）和峰值保持时间（毫秒）
+static const double kFallDbPerSec = 24.0;
+static const qint64 kHoldMs = 1000;
+// 布局：外边距、条间距、声道组与频段组之间的间隔、峰值刻度高度（像素）
+static const int kMargin = 4;
+static const int kSpacing = 2;
+static const int kGroupGap = 6;
+static const int kPeakPx = 2;
+
+MeterWidget::MeterWidget(QWidget *parent)
+    : QWidget(parent),
+      m_lastUpdateMs(0)
+{
+    Bar idle = {kMeterFloorDb, kMeterFloorDb, 0, 0, 0};
+    m_bars = QVector<Bar>(2 + kMeterBandCount, idle);
+    m_clock.start();
+}
+
+/*-------------------------------
+ * 左右声道一组、各频段一组，条宽按组件宽度均分
+ *------------------------------*/
+QRect MeterWidget::barRect(int index) const
+{
+    const int count = m_bars.size();
+    const int usable = width() - 2 * kMargin - kGroupGap - (count - 2) * kSpacing;
+    const int barWidth = qMax(2, usable / count);
+    int x = kMargin + index * (barWidth + kSpacing);
+    if (index >= 2) x += kGroupGap - kSpacing;
+    return QRect(x, kMargin, barWidth, qMax(0, height() - 2 * kMargin));
+}
+
+int MeterWidget::dbToPixels(double db) const
+{
+    const int h = qMax(0, height() - 2 * kMargin);
+    double ratio = (db - kDisplayFloorDb) / -kDisplayFloorDb;
+    return qBound(0, int(ratio * h + 0.5), h);
+}
+
+/*-------------------------------
+ * 渐变只在尺寸变化时画一次，每根条都从这两张图里截取，
+ * 刷新时不再创建渐变、不再逐像素计算颜色
+ *------------------------------*/
+void MeterWidget::rebuildGradients()
+{
+    QSize size = barRect(0).size();
+    if (size.isEmpty()) {
+        m_lit = m_unlit = QPixmap();
+        return;
+    }
+
+    QLinearGradient gradient(0, size.height(), 0, 0);
+    gradient.setColorAt(0.0, QColor(0x2E, 0xB8, 0x5C));
+    gradient.setColorAt((kWarnDb - kDisplayFloorDb) / -kDisplayFloorDb, QColor(0xF2, 0xC1, 0x2E));
+    gradient.setColorAt(1.0, QColor(0xEC, 0x41, 0x41));
+
+    m_lit = QPixmap(size);
+    m_lit.fill(Qt::transparent);
+    QPainter lit(&m_lit);
+    lit.fillRect(m_lit.rect(), gradient);
+    lit.end();
+
+    m_unlit = QPixmap(size);
+    m_unlit.fill(Qt::transparent);
+    QPainter unlit(&m_unlit);
+    unlit.setOpacity(0.18);
+    unlit.drawPixmap(0, 0, m_lit);
+    unlit.end();
+}
+
+void MeterWidget::setLevels(const AudioLevels &levels)
+{
+    qint64 now = m_clock.elapsed();
+    // 两次刷新间隔过长（暂停后恢复）时不要一下子掉到底
+    qint64 dt = qBound<qint64>(0, now - m_lastUpdateMs, 200);
+    m_lastUpdateMs = now;
+    double fallDb = kFallDbPerSec * dt / 1000.0;
+
+    QRegion dirty;
+    for (int c = 0; c < 2; ++c) {
+        updateBar(c, levels.rmsDb.value(c, kMeterFloorDb), levels.peakDb.value(c, kMeterFloorDb),
+                  now, fallDb, dirty);
+    }
+    // 频段只有 RMS，峰值刻度显示的是最近的最大值
+    for (int i = 0; i < kMeterBandCount; ++i) {
+        double db = levels.bandsDb.value(i, kMeterFloorDb);
+        updateBar(2 + i, db, db, now, fallDb, dirty);
+    }
+    if (!dirty.isEmpty()) update(dirty);
+
+    if (levels.centroidHz > 0) {
+        setToolTip(QString("频谱质心 %1 Hz，平坦度 %2")
+                   .arg(qRound(levels.centroidHz)).arg(levels.flatness, 0, 'f', 2));
+    }
+}
+
+void MeterWidget::updateBar(int index, double levelDb, double peakDb, qint64 now, double fallDb, QRegion &dirty)
+{
+    Bar &bar = m_bars[index];
+    bar.levelDb = qMax(levelDb, bar.levelDb - fallDb);
+    if (peakDb >= bar.holdDb) {
+        bar.holdDb = peakDb;
+        bar.holdUntil = now + kHoldMs;
+    } else if (now > bar.holdUntil) {
+        bar.holdDb = qMax(peakDb, bar.holdDb - fallDb);
+    }
+
+    int levelPx = dbToPixels(bar.levelDb);
+    int holdPx = dbToPixels(bar.holdDb);
+    if (levelPx == bar.levelPx && holdPx == bar.holdPx) return;
+
+    // 只重绘新旧高度之间的那一段，以及峰值刻度的新旧位置
+    QRect r = barRect(index);
+    if (levelPx != bar.levelPx) {
+        int lo = qMin(levelPx, bar.levelPx), hi = qMax(levelPx, bar.levelPx);
+        dirty += QRect(r.left(), r.bottom() + 1 - hi, r.width(), hi - lo);
+    }
+    if (holdPx != bar.holdPx) {
+        dirty += QRect(r.left(), r.bottom() + 1 - bar.holdPx - kPeakPx, r.width(), kPeakPx);
+        dirty += QRect(r.left(), r.bottom() + 1 - holdPx - kPeakPx, r.width(), kPeakPx);
+    }
+    bar.levelPx = levelPx;
+    bar.holdPx = holdPx;
+}
+
+void MeterWidget::reset()
+{
+    for (Bar &bar : m_bars) {
+        bar.levelDb = bar.holdDb = kMeterFloorDb;
+        bar.holdUntil = 0;
+        bar.levelPx = bar.holdPx = 0;
+    }
+    setToolTip(QString());
+    update();
+}
+
+void MeterWidget::paintEvent(QPaintEvent *event)
+{
+    if (m_lit.isNull()) return;
+
+    QPainter p(this);
+    for (int i = 0; i < m_bars.size(); ++i) {
+        QRect r = barRect(i);
+        if (!event->rect().intersects(r)) continue;
+
+        const Bar &bar = m_bars.at(i);
+        int h = r.height();
+        int unlitHeight = h - bar.levelPx;
+        if (unlitHeight > 0) {
+            p.drawPixmap(QRect(r.left(), r.top(), r.width(), unlitHeight),
+                         m_unlit, QRect(0, 0, r.width(), unlitHeight));
+        }
+        if (bar.levelPx > 0) {
+            p.drawPixmap(QRect(r.left(), r.top() + unlitHeight, r.width(), bar.levelPx),
+                         m_lit, QRect(0, unlitHeight, r.width(), bar.levelPx));
+        }
+        if (bar.holdPx > 0) {
+            int y = qMax(0, h - bar.holdPx - kPeakPx);
+            p.drawPixmap(QRect(r.left(), r.top() + y, r.width(), kPeakPx),
+                         m_lit, QRect(0, y, r.width(), kPeakPx));
+        }
+    }
+}
+
+void MeterWidget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    rebuildGradients();
+    for (Bar &bar : m_bars) {
+        bar.levelPx = dbToPixels(bar.levelDb);
+        bar.holdPx = dbToPixels(bar.holdDb);
+    }
+}
+
+void MeterWidget::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    emit visibilityChanged(true);
+}
+
+void MeterWidget::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    emit visibilityChanged(false);
+}
@@ -0,0 +1,57 @@
+/**
+ * @brief   : 电平表组件：左右声道 RMS/峰值 + 粗分频段，渐变预先画好缓存，只重绘变化的部分
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#ifndef METERWIDGET_H
+#define METERWIDGET_H
+
+#include <QWidget>
+#include <QPixmap>
+#include <QVector>
+#include <QElapsedTimer>
+#include "audioplayer.h"
+
+class MeterWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit MeterWidget(QWidget *parent = nullptr);
+
+    // 新读数：上升立即跟随，下落按固定速度衰减，峰值保持一段时间
+    void setLevels(const AudioLevels &levels);
+    void reset();
+
+    QSize sizeHint() const override { return QSize(96, 120); }
+
+signals:
+    void visibilityChanged(bool visible); // 不可见时播放器可以关掉测量
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private:
+    struct Bar {
+        double levelDb;   // 显示中的电平（已做衰减）
+        double holdDb;    // 峰值保持
+        qint64 holdUntil; // 保持到这个时刻（毫秒）后开始下落
+        int levelPx;      // 上次绘制的电平高度
+        int holdPx;       // 上次绘制的峰值刻度位置
+    };
+
+    QRect barRect(int index) const;
+    int dbToPixels(double db) const;
+    void rebuildGradients();
+    void updateBar(int index, double levelDb, double peakDb, qint64 now, double fallDb, QRegion &dirty);
+
+    QVector<Bar> m_bars;     // 0、1 为左右声道，之后是各频段
+    QPixmap m_lit;           // 一根电平条的亮色渐变，尺寸随组件变化重建
+    QPixmap m_unlit;         // 同一渐变的暗色版本，作为底色
+    QElapsedTimer m_clock;
+    qint64 m_lastUpdateMs;
+};
+
+#endif // METERWIDGET_H
@@ -0,0 +1,285 @@
+/**
+ * @brief   : mpv 事件通道实现
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#include "mpveventchannel.h"
+#include <cstring>
+#include <cstdlib>
+
+MpvEventChannel::MpvEventChannel(mpv_handle *mpv)
+    : QObject(nullptr),
+      m_mpv(mpv),
+      m_shutdown(false),
+      m_notifyPending(0)
+{
+}
+
+bool MpvEventChannel::pop(MpvEventRecord &rec)
+{
+    return m_queue.pop(rec);
+}
+
+void MpvEventChannel::acknowledge()
+{
+    m_notifyPending.storeRelease(0);
+}
+
+MpvCacheState MpvEventChannel::cacheState()
+{
+    QMutexLocker lock(&m_snapshotMutex);
+    return m_cacheState;
+}
+
+QList<MpvAudioDevice> MpvEventChannel::audioDevices()
+{
+    QMutexLocker lock(&m_snapshotMutex);
+    return m_audioDevices;
+}
+
+MpvMeterState MpvEventChannel::meterState()
+{
+    QMutexLocker lock(&m_snapshotMutex);
+    return m_meterState;
+}
+
+int MpvEventChannel::drain(int maxEvents)
+{
+    if (m_shutdown) return 0;
+
+    int handled = 0;
+    bool pushed = false;
+    while (handled < maxEvents) {
+        // 队列满说明 GUI 卡住了：事件先留在 mpv 里，绝不丢弃，也不阻塞其他内核
+        if (m_queue.isFull()) {
+            notify();
+            return -1;
+        }
+        mpv_event *event = mpv_wait_event(m_mpv, 0);
+        if (event->event_id == MPV_EVENT_NONE) break;
+        ++handled;
+        if (event->event_id == MPV_EVENT_SHUTDOWN) {
+            m_shutdown = true;
+            break;
+        }
+        MpvEventRecord rec;
+        if (convert(event, rec)) {
+            m_queue.push(rec);
+            pushed = true;
+        }
+    }
+
+    if (pushed) notify();
+    return handled;
+}
+
+void MpvEventChannel::notify()
+{
+    // 一批事件只通知一次，GUI acknowledge 之后才会再通知
+    if (m_notifyPending.testAndSetOrdered(0, 1)) {
+        emit eventsReady();
+    }
+}
+
+bool MpvEventChannel::convert(const mpv_event *event, MpvEventRecord &rec)
+{
+    rec.id = event->event_id;
+    rec.replyUserdata = event->reply_userdata;
+    rec.error = event->error;
+    rec.endReason = 0;
+    rec.hasValue = false;
+    rec.value = 0.0;
+    rec.timeUs = mpv_get_time_us(m_mpv);
+    rec.hookId = 0;
+
+    switch (event->event_id) {
+    case MPV_EVENT_PROPERTY_CHANGE: {
+        const mpv_event_property *prop = (const mpv_event_property *)event->data;
+        switch (prop->format) {
+        case MPV_FORMAT_DOUBLE:
+            rec.value = *(double *)prop->data;
+            rec.hasValue = true;
+            break;
+        case MPV_FORMAT_FLAG:
+            rec.value = *(int *)prop->data;
+            rec.hasValue = true;
+            break;
+        case MPV_FORMAT_INT64:
+            rec.value = double(*(int64_t *)prop->data);
+            rec.hasValue = true;
+            break;
+        case MPV_FORMAT_NODE:
+            if (strcmp(prop->name, "demuxer-cache-state") == 0) {
+                parseCacheState((const mpv_node *)prop->data);
+                rec.hasValue = true;
+            } else if (strcmp(prop->name, "audio-device-list") == 0) {
+                parseAudioDevices((const mpv_node *)prop->data);
+                rec.hasValue = true;
+            }
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+    case MPV_EVENT_GET_PROPERTY_REPLY: {
+        // 目前只有电平表按固定频率异步读取 af-metadata/<标签>
+        const mpv_event_property *prop = (const mpv_event_property *)event->data;
+        if (rec.error >= 0 && prop->format == MPV_FORMAT_NODE
+                && strncmp(prop->name, "af-metadata/", 12) == 0) {
+            parseMeterState((const mpv_node *)prop->data);
+            rec.hasValue = true;
+        }
+        return true;
+    }
+    case MPV_EVENT_END_FILE: {
+        const mpv_event_end_file *end = (const mpv_event_end_file *)event->data;
+        rec.endReason = end->reason;
+        rec.error = end->error;
+        return true;
+    }
+    case MPV_EVENT_HOOK: {
+        // on_load：只有 music-id:// 需要交给 GUI 解析，其余直接放行
+        const mpv_event_hook *hook = (const mpv_event_hook *)event->data;
+        rec.hookId = hook->id;
+        char *file = mpv_get_property_string(m_mpv, "stream-open-filename");
+        const size_t schemeLen = sizeof(kSongIdScheme) - 1;
+        bool ours = file && strncmp(file, kSongIdScheme, schemeLen) == 0;
+        if (ours) {
+            rec.value = atoi(file + schemeLen);
+            rec.hasValue = true;
+        }
+        mpv_free(file);
+        if (!ours) {
+            mpv_hook_continue(m_mpv, hook->id);
+            return false;
+        }
+        return true;
+    }
+    case MPV_EVENT_LOG_MESSAGE:
+        return false;
+    default:
+        return true;
+    }
+}
+
+static const mpv_node *nodeMapGet(const mpv_node *map, const char *key)
+{
+    if (!map || map->format != MPV_FORMAT_NODE_MAP) return nullptr;
+    const mpv_node_list *list = map->u.list;
+    for (int i = 0; i < list->num; ++i) {
+        if (strcmp(list->keys[i], key) == 0)
+            return &list->values[i];
+    }
+    return nullptr;
+}
+
+static double nodeToDouble(const mpv_node *node, double def = 0.0)
+{
+    if (!node) return def;
+    if (node->format == MPV_FORMAT_DOUBLE) return node->u.double_;
+    if (node->format == MPV_FORMAT_INT64) return double(node->u.int64);
+    if (node->format == MPV_FORMAT_FLAG) return node->u.flag;
+    return def;
+}
+
+static QString nodeToString(const mpv_node *node)
+{
+    if (!node || node->format != MPV_FORMAT_STRING) return QString();
+    return QString::fromUtf8(node->u.string);
+}
+
+void MpvEventChannel::parseCacheState(const mpv_node *node)
+{
+    MpvCacheState state;
+    const mpv_node *ranges = nodeMapGet(node, "seekable-ranges");
+    if (ranges && ranges->format == MPV_FORMAT_NODE_ARRAY) {
+        for (int i = 0; i < ranges->u.list->num; ++i) {
+            const mpv_node *r = &ranges->u.list->values[i];
+            state.seekableRanges.append(qMakePair(nodeToDouble(nodeMapGet(r, "start")),
+                                                  nodeToDouble(nodeMapGet(r, "end"))));
+        }
+    }
+    state.cacheEnd = nodeToDouble(nodeMapGet(node, "cache-end"));
+    state.rawInputRate = qint64(nodeToDouble(nodeMapGet(node, "raw-input-rate")));
+    state.eof = nodeToDouble(nodeMapGet(node, "eof")) != 0;
+
+    QMutexLocker lock(&m_snapshotMutex);
+    m_cacheState = state;
+}
+
+void MpvEventChannel::parseAudioDevices(const mpv_node *node)
+{
+    QList<MpvAudioDevice> devices;
+    if (node && node->format == MPV_FORMAT_NODE_ARRAY) {
+        for (int i = 0; i < node->u.list->num; ++i) {
+            const mpv_node *d = &node->u.list->values[i];
+            MpvAudioDevice dev;
+            dev.name = nodeToString(nodeMapGet(d, "name"));
+            dev.description = nodeToString(nodeMapGet(d, "description"));
+            devices.append(dev);
+        }
+    }
+
+    QMutexLocker lock(&m_snapshotMutex);
+    m_audioDevices = devices;
+}
+
+// astats 对静音报 -inf，统一压到下限
+static double meterDb(const char *text)
+{
+    double v = strtod(text, nullptr);
+    if (!(v > -1000.0)) return -1000.0;
+    return v;
+}
+
+/*-------------------------------
+ * af-metadata 是字符串到字符串的映射，键形如 lavfi.astats.1.RMS_level。
+ * 每帧都会整体替换，所以这里只挑需要的键，不保留上一次的值。
+ *------------------------------*/
+void MpvEventChannel::parseMeterState(const mpv_node *node)
+{
+    if (!node || node->format != MPV_FORMAT_NODE_MAP) return;
+
+    static const char astats[] = "lavfi.astats.";
+    static const char spectral[] = "lavfi.aspectralstats.";
+    MpvMeterState state;
+    int spectralChannels = 0;
+    const mpv_node_list *list = node->u.list;
+    for (int i = 0; i < list->num; ++i) {
+        const char *key = list->keys[i];
+        const mpv_node *value = &list->values[i];
+        if (value->format != MPV_FORMAT_STRING) continue;
+
+        const char *field = nullptr;
+        int channel = 0;
+        if (strncmp(key, astats, sizeof(astats) - 1) == 0) {
+            channel = int(strtol(key + sizeof(astats) - 1, (char **)&field, 10));
+            if (channel < 1 || channel > 64 || *field != '.') continue;
+            ++field;
+            QVector<double> *target = nullptr;
+            if (strcmp(field, "RMS_level") == 0) target = &state.rmsDb;
+            else if (strcmp(field, "Peak_level") == 0) target = &state.peakDb;
+            if (!target) continue;
+            while (target->size() < channel) target->append(-1000.0);
+            (*target)[channel - 1] = meterDb(value->u.string);
+        } else if (strncmp(key, spectral, sizeof(spectral) - 1) == 0) {
+            channel = int(strtol(key + sizeof(spectral) - 1, (char **)&field, 10));
+            if (channel < 1 || *field != '.') continue;
+            ++field;
+            if (strcmp(field, "centroid") == 0) {
+                state.centroidHz += strtod(value->u.string, nullptr);
+                ++spectralChannels;
+            } else if (strcmp(field, "flatness") == 0) {
+                state.flatness += strtod(value->u.string, nullptr);
+            }
+        }
+    }
+    if (spectralChannels > 0) {
+        state.centroidHz /= spectralChannels;
+        state.flatness /= spectralChannels;
+    }
+
+    QMutexLocker lock(&m_snapshotMutex);
+    m_meterState = state;
+}
@@ -0,0 +1,107 @@
+/**
+ * @brief   : 单个 mpv 内核的事件通道：事件线程写入，GUI 线程批量取出
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#ifndef MPVEVENTCHANNEL_H
+#define MPVEVENTCHANNEL_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QVector>
+#include <QPair>
+#include <QList>
+#include <QString>
+#include <mpv/client.h>
+#include "spscqueue.h"
+
+// 懒解析的歌曲地址：music-id://<歌曲 id>，在 on_load 钩子里换成真实地址
+static const char kSongIdScheme[] = "music-id://";
+
+/*
+ * 精简后的事件记录，只携带 GUI 需要的字段。
+ * mpv_event 里的指针在下一次 mpv_wait_event 后失效，所以必须在事件线程里拷贝出来。
+ */
+struct MpvEventRecord {
+    mpv_event_id id;
+    quint64 replyUserdata;  // 属性订阅 id / 异步请求 id
+    int error;              // mpv 错误码（>= 0 表示成功）
+    int endReason;          // MPV_EVENT_END_FILE 的原因
+    bool hasValue;          // 属性是否可用（MPV_FORMAT_NONE 时为 false）
+    double value;           // DOUBLE / FLAG / INT64 统一转成 double
+    qint64 timeUs;          // 事件线程取到事件时的 mpv_get_time_us，用于播放时钟
+    quint64 hookId;         // MPV_EVENT_HOOK 的 id，处理完必须 mpv_hook_continue
+};
+
+/*
+ * demuxer-cache-state 是节点属性，体积不固定，不适合放进事件记录。
+ * 事件线程解析后存一份最新快照，事件记录只负责通知“有变化”。
+ */
+struct MpvCacheState {
+    QVector<QPair<double, double>> seekableRanges; // 已缓存可直接 seek 的区间（秒）
+    double cacheEnd = 0.0;      // 缓存末尾位置（秒）
+    qint64 rawInputRate = 0;    // 网络输入速率（字节/秒）
+    bool eof = false;           // 已下载到文件末尾
+};
+
+// audio-device-list 中的一项
+struct MpvAudioDevice {
+    QString name;         // 传给 audio-device 的名称
+    QString description;  // 给用户看的描述
+};
+
+/*
+ * af-metadata 里测量滤镜的最新读数（astats / aspectralstats 写入的帧元数据）。
+ * 声道按 astats 的编号顺序排列，含义由插入滤镜的一方解释。
+ */
+struct MpvMeterState {
+    QVector<double> rmsDb;      // lavfi.astats.N.RMS_level
+    QVector<double> peakDb;     // lavfi.astats.N.Peak_level
+    double centroidHz = 0.0;    // lavfi.aspectralstats.N.centroid，各声道平均
+    double flatness = 0.0;      // lavfi.aspectralstats.N.flatness，各声道平均
+};
+
+/*
+ * 由 MpvEventLoop::attach 创建、detach 销毁。
+ * 事件线程是唯一的生产者，GUI 线程是唯一的消费者。
+ */
+class MpvEventChannel : public QObject
+{
+    Q_OBJECT
+public:
+    mpv_handle *handle() const { return m_mpv; }
+
+    bool pop(MpvEventRecord &rec);     // GUI 线程取事件
+    void acknowledge();                // GUI 开始取之前调用，允许再次通知
+    MpvCacheState cacheState();        // 最新的缓存快照（GUI 线程）
+    QList<MpvAudioDevice> audioDevices(); // 最新的输出设备列表（GUI 线程）
+    MpvMeterState meterState();        // 最新的电平读数（GUI 线程）
+
+signals:
+    void eventsReady();                // 队列由空变为非空（已合并）
+
+private:
+    friend class MpvEventLoop;
+    explicit MpvEventChannel(mpv_handle *mpv);
+
+    // 以下只在事件线程调用
+    int drain(int maxEvents);          // 取出已到达的事件，返回处理数；-1 表示队列已满
+    void notify();
+    bool convert(const mpv_event *event, MpvEventRecord &rec);
+    void parseCacheState(const mpv_node *node);
+    void parseAudioDevices(const mpv_node *node);
+    void parseMeterState(const mpv_node *node);
+
+    mpv_handle *m_mpv;
+    bool m_shutdown;                   // 收到 SHUTDOWN 后不再读取
+    QAtomicInt m_notifyPending;
+    SpscQueue<MpvEventRecord, 1024> m_queue;
+
+    QMutex m_snapshotMutex;
+    MpvCacheState m_cacheState;
+    QList<MpvAudioDevice> m_audioDevices;
+    MpvMeterState m_meterState;
+};
+
+#endif // MPVEVENTCHANNEL_H
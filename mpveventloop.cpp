@@ -0,0 +1,123 @@
+/**
+ * @brief   : 共享 mpv 事件线程实现
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#include "mpveventloop.h"
+
+// 没有事件时最长阻塞时间（毫秒），只用于周期性检查退出标志
+static const unsigned long kWaitTimeoutMs = 1000;
+// 有队列满（GUI 卡住）时的重试间隔（毫秒）
+static const unsigned long kRetryFullMs = 1;
+// 每个内核一轮最多取的事件数，避免一个繁忙的内核饿死其他区域
+static const int kMaxEventsPerRound = 64;
+
+static QMutex s_instanceMutex;
+static MpvEventLoop *s_instance = nullptr;
+static int s_refCount = 0;
+
+MpvEventLoop::MpvEventLoop()
+    : QThread(nullptr),
+      m_woken(false),
+      m_stop(false)
+{
+}
+
+MpvEventLoop::~MpvEventLoop()
+{
+    stop();
+}
+
+MpvEventChannel *MpvEventLoop::attach(mpv_handle *mpv)
+{
+    QMutexLocker lock(&s_instanceMutex);
+    if (!s_instance) {
+        s_instance = new MpvEventLoop();
+        s_instance->start();
+    }
+    ++s_refCount;
+
+    MpvEventChannel *channel = new MpvEventChannel(mpv);
+    {
+        QMutexLocker channelLock(&s_instance->m_channelMutex);
+        s_instance->m_channels.append(channel);
+    }
+    mpv_set_wakeup_callback(mpv, &MpvEventLoop::wakeup, s_instance);
+    // 注册前可能已有事件在排队（mpv_initialize 之后的属性初值），先唤醒一次
+    s_instance->wake();
+    return channel;
+}
+
+void MpvEventLoop::detach(MpvEventChannel *channel)
+{
+    if (!channel) return;
+
+    QMutexLocker lock(&s_instanceMutex);
+    if (!s_instance) return;
+
+    mpv_set_wakeup_callback(channel->handle(), nullptr, nullptr);
+    {
+        // 拿到锁说明事件线程不在处理这个通道
+        QMutexLocker channelLock(&s_instance->m_channelMutex);
+        s_instance->m_channels.removeOne(channel);
+    }
+    delete channel;
+
+    if (--s_refCount == 0) {
+        delete s_instance;
+        s_instance = nullptr;
+    }
+}
+
+void MpvEventLoop::wakeup(void *ctx)
+{
+    static_cast<MpvEventLoop *>(ctx)->wake();
+}
+
+void MpvEventLoop::wake()
+{
+    QMutexLocker lock(&m_wakeMutex);
+    m_woken = true;
+    m_wakeCond.wakeOne();
+}
+
+void MpvEventLoop::stop()
+{
+    if (!isRunning()) return;
+    {
+        QMutexLocker lock(&m_wakeMutex);
+        m_stop = true;
+        m_wakeCond.wakeOne();
+    }
+    wait();
+}
+
+void MpvEventLoop::run()
+{
+    unsigned long timeoutMs = kWaitTimeoutMs;
+    forever {
+        {
+            QMutexLocker lock(&m_wakeMutex);
+            if (!m_woken && !m_stop) m_wakeCond.wait(&m_wakeMutex, timeoutMs);
+            if (m_stop) return;
+            m_woken = false;
+        }
+
+        // 轮流取每个内核的事件；还有剩余或队列满时不进入长时间等待
+        bool more = false;
+        bool full = false;
+        QMutexLocker lock(&m_channelMutex);
+        for (MpvEventChannel *channel : m_channels) {
+            int handled = channel->drain(kMaxEventsPerRound);
+            if (handled < 0) full = true;
+            else if (handled == kMaxEventsPerRound) more = true;
+        }
+        lock.unlock();
+
+        if (more) {
+            QMutexLocker wakeLock(&m_wakeMutex);
+            m_woken = true;
+        }
+        timeoutMs = full ? kRetryFullMs : kWaitTimeoutMs;
+    }
+}
@@ -0,0 +1,53 @@
+/**
+ * @brief   : 共享的 mpv 事件线程：所有内核（多个播放区域 + 淡入淡出）共用一个线程，
+ *            通过各自的 MpvEventChannel 把事件批量交给 GUI 线程
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#ifndef MPVEVENTLOOP_H
+#define MPVEVENTLOOP_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <mpv/client.h>
+#include "mpveventchannel.h"
+
+/*
+ * 每个内核一个线程在 8~16 个区域时会有几十个线程常驻，
+ * 这里改为 mpv 唤醒回调 + 单线程轮流取事件。
+ * 线程按引用计数创建和退出：第一个 attach 启动，最后一个 detach 结束。
+ */
+class MpvEventLoop : public QThread
+{
+    Q_OBJECT
+public:
+    // 只在 GUI 线程调用
+    static MpvEventChannel *attach(mpv_handle *mpv);
+    // 返回后事件线程不会再访问该内核，可以安全 mpv_terminate_destroy
+    static void detach(MpvEventChannel *channel);
+
+protected:
+    void run() override;
+
+private:
+    MpvEventLoop();
+    ~MpvEventLoop();
+
+    static void wakeup(void *ctx);     // mpv 内部线程回调，只能置标志
+    void stop();
+    void wake();
+
+    // 唤醒标志：mpv 回调只碰这一把锁，避免和下面处理事件时的 mpv 调用互相等待
+    QMutex m_wakeMutex;
+    QWaitCondition m_wakeCond;
+    bool m_woken;
+    bool m_stop;
+
+    // 正在服务的通道；处理一轮事件期间持有，detach 借此等待本轮结束
+    QMutex m_channelMutex;
+    QVector<MpvEventChannel *> m_channels;
+};
+
+#endif // MPVEVENTLOOP_H
@@ -4,7 +4,9 @@
  * @date    : 2025.12.12
  **/
 #include "mpvplayer.h"
+#include "audiochunkcache.h"
 #include <QDebug>
+#include <QtMath>
 
 static void mpv_log_callback(void *userdata, const mpv_event_log_message *msg)
 {
@@ -12,90 +14,977 @@ static void mpv_log_callback(void *userdata, const mpv_event_log_message *msg)
     qDebug() << "[mpv]" << msg->prefix << msg->level << msg->text;
 }
 
+// 淡变期间音量刷新间隔（毫秒），只在淡变时运行
+static const int kFadeTickMs = 20;
+// 拖动时目标落在缓存末尾之后这么近（毫秒），就改落到缓存末尾，省一次重新下载
+static const qint64 kSnapToCacheMs = 2000;
+// 未缓存位置起播前需要下载的音频时长（秒），对应 demuxer-readahead-secs + cache-pause-wait
+static const double kRefillSec = 1.3;
+// 卡在缓冲中超过该时长（毫秒）视为断流
+static const int kStallTimeoutMs = 8000;
+// on_load 钩子等待地址的上限（毫秒），超时放行让 mpv 报错走续播流程
+static const int kHookTimeoutMs = 15000;
+// 预排曲目在当前曲目结束前这么久（秒）解析地址：分析结果（增益/裁剪）来得及，
+// 又远早于 mpv 预读下一项的时间点
+static const double kQueueResolveLeadSec = 20.0;
+// 电平表刷新间隔（毫秒），约 25 Hz
+static const int kMeterIntervalMs = 40;
+// on_load 钩子的 reply_userdata 与优先级
+static const quint64 kLoadHookId = 1;
+static const int kLoadHookPriority = 50;
+
+// 低延迟输出配置：audio-buffer 单位秒，pipewire/pulse 缓冲单位毫秒；
+// 不支持的选项（平台没有该输出驱动）设置失败会被忽略
+static const char *const kLowLatencyOptions[][2] = {
+    {"audio-buffer", "0.03"},
+    {"pipewire-buffer", "10"},
+    {"pulse-buffer", "20"},
+    {"pulse-latency-hacks", "yes"},
+    {"audio-wait-open", "0"},
+};
+
 MPVPlayer::MPVPlayer(QObject *parent)
-    : QObject(parent),
+    : AudioPlayer(parent),
       m_mpv(nullptr),
-      m_playing(false)
+      m_channel(nullptr),
+      m_mpvAux(nullptr),
+      m_auxChannel(nullptr),
+      m_playing(false),
+      m_fileLoaded(false),
+      m_paused(false),
+      m_nextRequestId(1),
+      m_pendingLoadId(0),
+      m_hasQueued(false),
+      m_queueSongId(0),
+      m_queueResolving(false),
+      m_queueTrimEndSec(0.0),
+      m_queueAtEof(false),
+      m_lastPositionMs(-1),
+      m_scrubbing(false),
+      m_seekInFlight(false),
+      m_inFlightExact(false),
+      m_seekRequestId(0),
+      m_pendingSeekMs(-1),
+      m_pendingSeekExact(false),
+      m_inputRate(0),
+      m_audioBitrate(0.0),
+      m_chunkCache(nullptr),
+      m_lowLatency(false),
+      m_measuringLatency(false),
+      m_latencyStartSec(0.0),
+      m_metering(false),
+      m_meterRequestId(0),
+      m_awaitingFirstAudio(false),
+      m_volume(100),
+      m_crossfadeSec(0.0),
+      m_fading(false),
+      m_fadeOutEndSec(0.0)
+{
+    m_mpv = createCore();
+    m_clock.setHandle(m_mpv);
+
+    // 事件在共享的事件线程等待，GUI 卡顿不会拖慢 END_FILE 等状态处理
+    m_channel = attachCore(m_mpv);
+
+    m_crossfadeStartTimer.setSingleShot(true);
+    connect(&m_crossfadeStartTimer, &QTimer::timeout, this, &MPVPlayer::startCrossfade);
+    m_fadeTimer.setInterval(kFadeTickMs);
+    connect(&m_fadeTimer, &QTimer::timeout, this, &MPVPlayer::onFadeTick);
+
+    m_queueResolveTimer.setSingleShot(true);
+    connect(&m_queueResolveTimer, &QTimer::timeout, this, &MPVPlayer::resolveQueued);
+
+    m_stallTimer.setSingleShot(true);
+    m_stallTimer.setInterval(kStallTimeoutMs);
+    connect(&m_stallTimer, &QTimer::timeout, this, &MPVPlayer::onStallTimeout);
+
+    m_meterTimer.setInterval(kMeterIntervalMs);
+    connect(&m_meterTimer, &QTimer::timeout, this, &MPVPlayer::pollMeters);
+}
+
+MPVPlayer::~MPVPlayer()
 {
-    m_mpv = mpv_create();
-    if (!m_mpv) {
+    destroyCore(m_mpvAux, m_auxChannel);
+    m_mpvAux = nullptr;
+    destroyCore(m_mpv, m_channel);
+    m_mpv = nullptr;
+}
+
+mpv_handle *MPVPlayer::createCore()
+{
+    mpv_handle *mpv = mpv_create();
+    if (!mpv) {
         qFatal("mpv_create failed");
     }
 
     // 请求日志输出
-    mpv_request_log_messages(m_mpv, "info");
+    mpv_request_log_messages(mpv, "info");
+
+    applyAudioOnlyProfile(mpv);
 
-    // 如果只做音频，可以不设置 vo；但保留默认设置
-    // mpv_set_option_string(m_mpv, "vo", "null");
+    // 无缝播放：音频输出在曲目间不重建，播放列表下一项提前打开
+    mpv_set_option_string(mpv, "gapless-audio", "yes");
+    mpv_set_option_string(mpv, "prefetch-playlist", "yes");
 
-    if (mpv_initialize(m_mpv) < 0) {
+    if (mpv_initialize(mpv) < 0) {
         qFatal("mpv_initialize failed");
     }
 
-    // 轮询定时器用于更新进度/时长/播放状态
-    m_pollTimer.setInterval(500);
-    connect(&m_pollTimer, &QTimer::timeout, this, &MPVPlayer::onPoll);
-    m_pollTimer.start();
+    // 订阅属性变化：只有 mpv 报告变化时才会产生事件，暂停时不再空转
+    mpv_observe_property(mpv, PropTimePos, "time-pos", MPV_FORMAT_DOUBLE);
+    mpv_observe_property(mpv, PropDuration, "duration", MPV_FORMAT_DOUBLE);
+    mpv_observe_property(mpv, PropPause, "pause", MPV_FORMAT_FLAG);
+    mpv_observe_property(mpv, PropSpeed, "speed", MPV_FORMAT_DOUBLE);
+    mpv_observe_property(mpv, PropPlaylistPos, "playlist-pos", MPV_FORMAT_INT64);
+    mpv_observe_property(mpv, PropCacheState, "demuxer-cache-state", MPV_FORMAT_NODE);
+    mpv_observe_property(mpv, PropAudioBitrate, "audio-bitrate", MPV_FORMAT_DOUBLE);
+    mpv_observe_property(mpv, PropPausedForCache, "paused-for-cache", MPV_FORMAT_FLAG);
+
+    // music-id:// 在加载时才解析真实地址
+    mpv_hook_add(mpv, kLoadHookId, "on_load", kLoadHookPriority);
+
+    mpv_observe_property(mpv, PropAudioDeviceList, "audio-device-list", MPV_FORMAT_NODE);
+
+    if (m_chunkCache) m_chunkCache->registerWith(mpv);
+
+    // 记下默认输出参数，关闭低延迟时恢复；第二个内核沿用当前设置
+    if (m_defaultOutputOptions.isEmpty()) {
+        for (const auto &opt : kLowLatencyOptions) {
+            char *value = mpv_get_property_string(mpv, opt[0]);
+            if (value) {
+                m_defaultOutputOptions.insert(opt[0], value);
+                mpv_free(value);
+            }
+        }
+    }
+    applyOutputSettings(mpv);
+    applyAudioFilters(mpv);
+    return mpv;
 }
 
-MPVPlayer::~MPVPlayer()
+/*-------------------------------
+ * 纯音频 + 快速启动：
+ * 1. 不创建视频输出、不解码封面、不加载 OSD / 脚本 / 配置文件
+ * 2. 不等缓存填满就开始播放，探测数据量减到够识别常见音频格式即可
+ *------------------------------*/
+void MPVPlayer::applyAudioOnlyProfile(mpv_handle *mpv)
 {
-    if (m_mpv) {
-        mpv_terminate_destroy(m_mpv);
-        m_mpv = nullptr;
+    static const char *const options[][2] = {
+        // 不要视频与界面相关子系统
+        {"vid", "no"},
+        {"vo", "null"},
+        {"audio-display", "no"},
+        {"osd-level", "0"},
+        {"osc", "no"},
+        {"input-default-bindings", "no"},
+        {"input-vo-keyboard", "no"},
+        // 不扫描配置、脚本和外部文件
+        {"config", "no"},
+        {"load-scripts", "no"},
+        {"ytdl", "no"},
+        {"sub-auto", "no"},
+        {"audio-file-auto", "no"},
+        {"cover-art-auto", "no"},
+        // 快速起播：小缓冲、少探测
+        {"cache-pause-initial", "no"},
+        {"cache-pause-wait", "0.3"},
+        {"demuxer-readahead-secs", "1"},
+        {"demuxer-lavf-probesize", "32768"},
+        {"demuxer-lavf-analyzeduration", "0.3"},
+        {"demuxer-max-bytes", "32MiB"},
+        {"demuxer-max-back-bytes", "16MiB"},
+    };
+    for (const auto &opt : options) {
+        if (mpv_set_option_string(mpv, opt[0], opt[1]) < 0) {
+            qWarning() << "mpv option not supported:" << opt[0];
+        }
     }
 }
 
-void MPVPlayer::playUrl(const QString &url)
+MpvEventChannel *MPVPlayer::attachCore(mpv_handle *mpv)
 {
-    if (!m_mpv) return;
+    MpvEventChannel *channel = MpvEventLoop::attach(mpv);
+    connect(channel, &MpvEventChannel::eventsReady, this, &MPVPlayer::onMpvEvents, Qt::QueuedConnection);
+    return channel;
+}
+
+void MPVPlayer::destroyCore(mpv_handle *mpv, MpvEventChannel *channel)
+{
+    if (!mpv) return;
+    m_trimEndSec.remove(mpv);
+    MpvEventLoop::detach(channel);
+    mpv_terminate_destroy(mpv);
+}
+
+quint64 MPVPlayer::playUrl(const QString &url, qint64 startMs)
+{
+    if (!m_mpv) return 0;
+
+    // 新的加载取代旧的：中止还在进行的 loadfile
+    if (m_pendingLoadId) {
+        mpv_abort_async_command(m_mpv, m_pendingLoadId);
+        m_pendingLoadId = 0;
+    }
+
+    int paused = 0;
+    setPropertyAsync("pause", MPV_FORMAT_FLAG, &paused);
+
+    m_loadTimer.start();
+    m_awaitingFirstAudio = true;
+
+    // replace 会清空整个播放列表，预排的下一首一起作废
+    m_hasQueued = false;
+    m_queueSongId = 0;
+    m_queueResolving = false;
+    m_queueResolveTimer.stop();
+    m_queueAtEof = false;
+    m_crossfadeNextUrl.clear();
+    m_crossfadeStartTimer.stop();
+    if (m_fading) finishCrossfade();
+    m_stallTimer.stop();
+
     QByteArray u = url.toUtf8();
-    const char *args[] = {"loadfile", u.constData(), nullptr};
-    int r = mpv_command(m_mpv, args);
-    Q_UNUSED(r);
-    m_playing = true;
-    emit stateChanged(true);
+    // loadfile <url> <flags> <index> <options>，start 只对本文件生效
+    QByteArray options = startMs >= 0
+            ? "start=" + QByteArray::number(startMs / 1000.0, 'f', 3)
+            : QByteArray();
+    const char *args[] = {"loadfile", u.constData(), "replace", "-1", options.constData(), nullptr};
+    m_pendingLoadId = commandAsync(args);
+    // 播放状态等 FILE_LOADED 确认后再更新
+    return m_pendingLoadId;
 }
 
-void MPVPlayer::play()
+/*-------------------------------
+ * 播放列表始终保持 [当前, 下一首] 两项：
+ * 切到下一首后清掉前面的，重复预排时替换旧的
+ *------------------------------*/
+quint64 MPVPlayer::queueNext(const QString &url)
 {
-    if (!m_mpv) return;
+    if (!m_mpv) return 0;
+    clearQueue();
+
+    // 淡入淡出模式下不进 mpv 播放列表，等淡入淡出点在另一个内核上启动
+    if (m_crossfadeSec > 0) {
+        m_crossfadeNextUrl = url;
+        m_hasQueued = true;
+        armCrossfade();
+        return 0;
+    }
+
+    QByteArray u = url.toUtf8();
+    const char *args[] = {"loadfile", u.constData(), "append", nullptr};
+    m_hasQueued = true;
+    return commandAsync(args);
+}
+
+/*-------------------------------
+ * 按 id 预排：mpv 预读下一项时不经过 on_load，预读的是播放列表里的原始地址，
+ * 所以不能把 music-id:// 排进去等钩子解析。先在结束前解析好，
+ * 再把最终地址（分块缓存的 mcache://）追加进播放列表，预读才能生效。
+ * 淡入淡出在第二个内核上 loadfile，没有预读，仍按 id 在加载时解析
+ *------------------------------*/
+quint64 MPVPlayer::queueNextSong(int songId)
+{
+    if (m_crossfadeSec > 0) return queueNext(songUrl(songId));
+    if (!m_mpv) return 0;
+    clearQueue();
+    m_queueSongId = songId;
+    m_queueResolving = false;
+    m_hasQueued = true;
+    armQueueResolve();
+    return 0;
+}
+
+// 与淡入淡出起点一样按播放时钟计算，时钟变化时重新计算
+void MPVPlayer::armQueueResolve()
+{
+    if (!m_queueSongId || m_queueResolving) {
+        m_queueResolveTimer.stop();
+        return;
+    }
+    // 时长未知（还在加载）或暂停时先不排，下一批事件到来时再算
+    double endSec = playEndSec(m_mpv, m_clock);
+    if (!m_fileLoaded || !m_clock.isValid() || !m_clock.isRunning() || endSec <= 0) {
+        m_queueResolveTimer.stop();
+        return;
+    }
+    double untilSec = (endSec - kQueueResolveLeadSec - m_clock.positionSec()) / qMax(0.01, m_clock.speed());
+    m_queueResolveTimer.start(qMax(0, int(untilSec * 1000)));
+}
+
+void MPVPlayer::resolveQueued()
+{
+    if (!m_queueSongId || m_queueResolving) return;
+    m_queueResolving = true;
+    emit songUrlRequested(m_queueSongId);
+}
+
+// 预排曲目的地址到了：增益和裁剪作为该项的文件选项一起追加，切过去时自动生效
+void MPVPlayer::appendQueued(const QString &url, double gainDb, const TrackTrim &trim)
+{
+    int songId = m_queueSongId;
+    bool atEof = m_queueAtEof;
+    m_queueSongId = 0;
+    m_queueResolving = false;
+    m_queueAtEof = false;
+    if (url.isEmpty()) {
+        // 解析失败：不排了；当前曲目已经播完的话，按播放结束交给上层
+        m_hasQueued = false;
+        if (atEof) emit playbackFinished();
+        return;
+    }
+
+    QString target = url;
+    if (m_chunkCache) {
+        m_chunkCache->setSource(songId, url);
+        target = AudioChunkCache::streamUrl(songId);
+    }
+    QByteArray options = "volume-gain=" + QByteArray::number(gainDb, 'f', 2);
+    if (trim.startMs > 0) options += ",start=" + QByteArray::number(trim.startMs / 1000.0, 'f', 3);
+    if (trim.endMs > 0) options += ",end=" + QByteArray::number(trim.endMs / 1000.0, 'f', 3);
+    double trimEndSec = trim.endMs > 0 ? trim.endMs / 1000.0 : 0.0;
+    QByteArray u = target.toUtf8();
+
+    if (atEof) {
+        // 地址晚于 EOF 到达：mpv 已空闲，append 不会再起播，直接替换加载并按切歌处理
+        m_hasQueued = false;
+        if (trimEndSec > 0) m_trimEndSec.insert(m_mpv, trimEndSec);
+        else m_trimEndSec.remove(m_mpv);
+        m_loadTimer.start();
+        m_awaitingFirstAudio = true;
+        const char *args[] = {"loadfile", u.constData(), "replace", "-1", options.constData(), nullptr};
+        m_pendingLoadId = commandAsync(args);
+        emit trackAdvanced();
+        return;
+    }
+
+    m_queueTrimEndSec = trimEndSec;
+    const char *args[] = {"loadfile", u.constData(), "append", "-1", options.constData(), nullptr};
+    commandAsync(args);
+}
+
+QString MPVPlayer::songUrl(int songId)
+{
+    return QString::fromLatin1(kSongIdScheme) + QString::number(songId);
+}
+
+/*-------------------------------
+ * on_load 钩子：mpv 停在加载前等待，我们把 stream-open-filename
+ * 改成刚解析出的地址后放行；超时也放行，由 mpv 报错触发续播
+ *------------------------------*/
+void MPVPlayer::handleLoadHook(mpv_handle *mpv, const MpvEventRecord &rec)
+{
+    int songId = int(rec.value);
+    quint64 hookId = rec.hookId;
+    m_pendingHooks.insert(songId, PendingHook{mpv, hookId});
+
+    QTimer::singleShot(kHookTimeoutMs, this, [this, songId, hookId]() {
+        continueHook(songId, hookId, QString(), 0.0, TrackTrim());
+    });
+    emit songUrlRequested(songId);
+}
+
+void MPVPlayer::provideSongUrl(int songId, const QString &url, double gainDb, const TrackTrim &trim)
+{
+    // 同一首可能同时被当前和预排两个钩子等待，全部放行
+    const QList<PendingHook> hooks = m_pendingHooks.values(songId);
+    for (const PendingHook &h : hooks) {
+        continueHook(songId, h.hookId, url, gainDb, trim);
+    }
+    if (m_queueResolving && songId == m_queueSongId) appendQueued(url, gainDb, trim);
+}
+
+void MPVPlayer::setAudioDevice(const QString &name)
+{
+    m_audioDevice = name;
+    applyOutputSettings(m_mpv);
+    if (m_mpvAux) applyOutputSettings(m_mpvAux);
+}
+
+void MPVPlayer::setLowLatency(bool enabled)
+{
+    if (enabled == m_lowLatency) return;
+    m_lowLatency = enabled;
+
+    const char *reload[] = {"ao-reload", nullptr};
+    applyOutputSettings(m_mpv);
+    commandAsync(m_mpv, reload);
+    if (m_mpvAux) {
+        applyOutputSettings(m_mpvAux);
+        commandAsync(m_mpvAux, reload);
+    }
+}
+
+void MPVPlayer::applyOutputSettings(mpv_handle *mpv)
+{
+    if (!m_audioDevice.isEmpty()) {
+        QByteArray dev = m_audioDevice.toUtf8();
+        const char *value = dev.constData();
+        setPropertyAsync(mpv, "audio-device", MPV_FORMAT_STRING, &value);
+    }
+
+    for (const auto &opt : kLowLatencyOptions) {
+        QByteArray value = m_lowLatency ? QByteArray(opt[1]) : m_defaultOutputOptions.value(opt[0]);
+        if (value.isEmpty()) continue;
+        // 选项不存在时只是设置失败，不影响播放
+        mpv_set_property_string(mpv, opt[0], value.constData());
+    }
+}
+
+/*-------------------------------
+ * DSP 链：一个带标签的 lavfi 滤镜 @dsp，图里每个滤镜都有实例名。
+ * 参数修改走 af-command <标签> <参数> <值> <实例名>，不重建滤镜图、不丢音频；
+ * 压缩器开关用 mix，限幅器关闭时把上限放到 0 dBFS，也都不需要重建。
+ *------------------------------*/
+static QByteArray dspNumber(double v)
+{
+    return QByteArray::number(v, 'f', 6);
+}
+
+static double dbToLinear(double db)
+{
+    return qPow(10.0, db / 20.0);
+}
+
+// acompressor / alimiter 的参数范围，超出时 ffmpeg 拒绝整个命令
+static double compThreshold(const DspSettings &d) { return dbToLinear(qBound(-60.0, d.compThresholdDb, 0.0)); }
+static double compMakeup(const DspSettings &d)    { return dbToLinear(qBound(0.0, d.compMakeupDb, 36.0)); }
+static double compRatio(const DspSettings &d)     { return qBound(1.0, d.compRatio, 20.0); }
+static double compAttack(const DspSettings &d)    { return qBound(0.01, d.compAttackMs, 2000.0); }
+static double compRelease(const DspSettings &d)   { return qBound(0.01, d.compReleaseMs, 9000.0); }
+static double limiterLimit(const DspSettings &d)
+{
+    return d.limiterEnabled ? dbToLinear(qBound(-24.0, d.limiterCeilingDb, 0.0)) : 1.0;
+}
+
+QByteArray MPVPlayer::dspGraph() const
+{
+    QByteArray graph;
+    for (int i = 0; i < kEqBandCount; ++i) {
+        graph += "equalizer@eq" + QByteArray::number(i)
+                + "=f=" + dspNumber(kEqBandFreqs[i]) + ":t=o:w=1:g=" + dspNumber(m_dsp.eqGainsDb.value(i)) + ",";
+    }
+    graph += "acompressor@comp=threshold=" + dspNumber(compThreshold(m_dsp))
+            + ":ratio=" + dspNumber(compRatio(m_dsp))
+            + ":attack=" + dspNumber(compAttack(m_dsp))
+            + ":release=" + dspNumber(compRelease(m_dsp))
+            + ":makeup=" + dspNumber(compMakeup(m_dsp))
+            + ":mix=" + (m_dsp.compressorEnabled ? "1" : "0") + ",";
+    // level=0：不做自动电平，否则限幅器会把整体响度拉到上限
+    graph += "alimiter@limit=limit=" + dspNumber(limiterLimit(m_dsp)) + ":level=0";
+    return "@dsp:lavfi=[" + graph + "]";
+}
+
+void MPVPlayer::applyAudioFilters(mpv_handle *mpv)
+{
+    QByteArray af;
+    if (m_dsp.enabled) af = dspGraph();
+    // 测量放在最后，量到的是 DSP 之后实际送往输出的声音
+    if (m_metering) {
+        if (!af.isEmpty()) af += ",";
+        af += meterGraph();
+    }
+    const char *value = af.constData();
+    setPropertyAsync(mpv, "af", MPV_FORMAT_STRING, &value);
+}
+
+void MPVPlayer::sendDspCommand(const char *command, double value, const QByteArray &target)
+{
+    QByteArray arg = dspNumber(value);
+    const char *args[] = {"af-command", "dsp", command, arg.constData(), target.constData(), nullptr};
+    commandAsync(m_mpv, args);
+    if (m_mpvAux) commandAsync(m_mpvAux, args);
+}
+
+void MPVPlayer::setDsp(const DspSettings &dsp)
+{
+    DspSettings old = m_dsp;
+    m_dsp = dsp;
+
+    // 总开关：插入/移除滤镜链，只有这里会重建
+    if (dsp.enabled != old.enabled) {
+        applyAudioFilters(m_mpv);
+        if (m_mpvAux) applyAudioFilters(m_mpvAux);
+        return;
+    }
+    // 关闭时只记下参数，打开时随滤镜链一起生效
+    if (!dsp.enabled) return;
+
+    for (int i = 0; i < kEqBandCount; ++i) {
+        if (dsp.eqGainsDb.value(i) != old.eqGainsDb.value(i))
+            sendDspCommand("gain", dsp.eqGainsDb.value(i), "eq" + QByteArray::number(i));
+    }
+
+    if (compThreshold(dsp) != compThreshold(old)) sendDspCommand("threshold", compThreshold(dsp), "comp");
+    if (compRatio(dsp) != compRatio(old))         sendDspCommand("ratio", compRatio(dsp), "comp");
+    if (compAttack(dsp) != compAttack(old))       sendDspCommand("attack", compAttack(dsp), "comp");
+    if (compRelease(dsp) != compRelease(old))     sendDspCommand("release", compRelease(dsp), "comp");
+    if (compMakeup(dsp) != compMakeup(old))       sendDspCommand("makeup", compMakeup(dsp), "comp");
+    if (dsp.compressorEnabled != old.compressorEnabled)
+        sendDspCommand("mix", dsp.compressorEnabled ? 1.0 : 0.0, "comp");
+
+    if (limiterLimit(dsp) != limiterLimit(old))   sendDspCommand("limit", limiterLimit(dsp), "limit");
+}
+
+/*-------------------------------
+ * 电平表：在已经解码的音频上做测量，不会再解码一次。
+ * 1. aspectralstats 在立体声上给出频谱质心/平坦度
+ * 2. 另分一路混成单声道，经几个带通滤波器得到粗分频段
+ * 3. amerge 把主路和各频段并成多声道，一个 astats 同时测出所有声道的 RMS/峰值
+ * 4. 最后 pan 只保留前两个声道，输出和输入完全相同
+ * 读数写进帧元数据，由 af-metadata/meter 读出；ffmpeg 的 af 图里有方括号，
+ * 所以用 mpv 的 %长度% 引用，而不是 [...]。
+ *------------------------------*/
+QByteArray MPVPlayer::meterGraph()
+{
+    QByteArray graph = "aformat=channel_layouts=stereo,aspectralstats=win_size=1024,asplit=2[main][side];";
+    graph += "[side]pan=mono|c0=0.5*c0+0.5*c1,asplit=" + QByteArray::number(kMeterBandCount);
+    for (int i = 0; i < kMeterBandCount; ++i) graph += "[s" + QByteArray::number(i) + "]";
+    graph += ";";
+    for (int i = 0; i < kMeterBandCount; ++i) {
+        graph += "[s" + QByteArray::number(i) + "]bandpass=f=" + dspNumber(kMeterBandFreqs[i])
+                + ":t=o:w=1.3[b" + QByteArray::number(i) + "];";
+    }
+    graph += "[main]";
+    for (int i = 0; i < kMeterBandCount; ++i) graph += "[b" + QByteArray::number(i) + "]";
+    // reset=1：每帧重新统计，读到的就是当前这一帧的电平
+    graph += "amerge=inputs=" + QByteArray::number(kMeterBandCount + 1)
+            + ",astats=metadata=1:reset=1:measure_overall=none:measure_perchannel=RMS_level+Peak_level"
+            + ",pan=stereo|c0=c0|c1=c1";
+    return "@meter:lavfi=%" + QByteArray::number(graph.size()) + "%" + graph;
+}
+
+void MPVPlayer::setMetering(bool enabled)
+{
+    if (enabled == m_metering) return;
+    m_metering = enabled;
+    applyAudioFilters(m_mpv);
+    if (m_mpvAux) applyAudioFilters(m_mpvAux);
+    updateMeterTimer();
+}
+
+void MPVPlayer::updateMeterTimer()
+{
+    bool run = m_metering && m_playing;
+    if (run == m_meterTimer.isActive()) return;
+    if (run) {
+        m_meterTimer.start();
+        return;
+    }
+    m_meterTimer.stop();
+    m_meterRequestId = 0;
+    // 停下时归零一次，界面的电平条随之落下
+    if (m_metering) {
+        AudioLevels silent;
+        silent.rmsDb = silent.peakDb = QVector<double>(2, kMeterFloorDb);
+        silent.bandsDb = QVector<double>(kMeterBandCount, kMeterFloorDb);
+        emit levelsChanged(silent);
+    }
+}
+
+void MPVPlayer::pollMeters()
+{
+    // 上一次还没回来就跳过，界面卡顿时不会堆积请求
+    if (m_meterRequestId) return;
+    m_meterRequestId = m_nextRequestId++;
+    if (mpv_get_property_async(m_mpv, m_meterRequestId, "af-metadata/meter", MPV_FORMAT_NODE) < 0) {
+        m_meterRequestId = 0;
+    }
+}
+
+void MPVPlayer::handleMeterReply(const MpvEventRecord &rec)
+{
+    if (rec.replyUserdata != m_meterRequestId) return;
+    m_meterRequestId = 0;
+    // 滤镜刚插入或文件还没开始解码时属性不可用，下次再读
+    if (!rec.hasValue || !m_meterTimer.isActive()) return;
+
+    MpvMeterState state = m_channel->meterState();
+    // astats 声道 1、2 是左右声道，之后依次是各频段
+    AudioLevels levels;
+    for (int c = 0; c < 2; ++c) {
+        levels.rmsDb << qMax(kMeterFloorDb, state.rmsDb.value(c, kMeterFloorDb));
+        levels.peakDb << qMax(kMeterFloorDb, state.peakDb.value(c, kMeterFloorDb));
+    }
+    for (int i = 0; i < kMeterBandCount; ++i) {
+        levels.bandsDb << qMax(kMeterFloorDb, state.rmsDb.value(2 + i, kMeterFloorDb));
+    }
+    levels.centroidHz = state.centroidHz;
+    levels.flatness = state.flatness;
+    emit levelsChanged(levels);
+}
+
+void MPVPlayer::setChunkCache(AudioChunkCache *cache)
+{
+    m_chunkCache = cache;
+    if (!cache) return;
+    cache->registerWith(m_mpv);
+    if (m_mpvAux) cache->registerWith(m_mpvAux);
+}
+
+void MPVPlayer::continueHook(int songId, quint64 hookId, const QString &url, double gainDb, const TrackTrim &trim)
+{
+    auto it = m_pendingHooks.find(songId);
+    while (it != m_pendingHooks.end() && it.key() == songId) {
+        if (it->hookId != hookId) {
+            ++it;
+            continue;
+        }
+        mpv_handle *mpv = it->mpv;
+        m_pendingHooks.erase(it);
+        if (!url.isEmpty()) {
+            QString target = url;
+            // 经由分块缓存读取；地址过期换新后已缓存的分块仍然可用
+            if (m_chunkCache) {
+                m_chunkCache->setSource(songId, url);
+                target = AudioChunkCache::streamUrl(songId);
+            }
+            mpv_set_property_string(mpv, "stream-open-filename", target.toUtf8().constData());
+            // 响度归一化：只对这个文件生效，下一首加载时自动恢复
+            QByteArray gain = QByteArray::number(gainDb, 'f', 2);
+            mpv_set_property_string(mpv, "file-local-options/volume-gain", gain.constData());
+            applyTrim(mpv, trim);
+        }
+        mpv_hook_continue(mpv, hookId);
+        return;
+    }
+}
+
+/*-------------------------------
+ * 跳过首尾静音：start/end 设为本文件的选项，下一首加载时自动恢复。
+ * 续播或按位置起播时 loadfile 已带了 start，不能被裁剪点覆盖。
+ * 播到裁剪终点 mpv 就按文件结束处理，下一首随之提前开始。
+ *------------------------------*/
+void MPVPlayer::applyTrim(mpv_handle *mpv, const TrackTrim &trim)
+{
+    if (trim.startMs > 0) {
+        char *start = mpv_get_property_string(mpv, "file-local-options/start");
+        bool explicitStart = start && qstrcmp(start, "none") != 0;
+        mpv_free(start);
+        if (!explicitStart) {
+            QByteArray value = QByteArray::number(trim.startMs / 1000.0, 'f', 3);
+            mpv_set_property_string(mpv, "file-local-options/start", value.constData());
+        }
+    }
+    if (trim.endMs > 0) {
+        QByteArray value = QByteArray::number(trim.endMs / 1000.0, 'f', 3);
+        mpv_set_property_string(mpv, "file-local-options/end", value.constData());
+        m_trimEndSec.insert(mpv, trim.endMs / 1000.0);
+    } else {
+        m_trimEndSec.remove(mpv);
+    }
+}
+
+// 当前文件实际播放到哪里结束：有裁剪终点时取裁剪终点
+double MPVPlayer::playEndSec(mpv_handle *mpv, const PlaybackClock &clock) const
+{
+    double end = clock.durationSec();
+    double trimEnd = m_trimEndSec.value(mpv, 0.0);
+    if (trimEnd > 0 && (end <= 0 || trimEnd < end)) end = trimEnd;
+    return end;
+}
+
+void MPVPlayer::clearQueue()
+{
+    if (!m_mpv || !m_hasQueued) return;
+    if (!m_crossfadeNextUrl.isEmpty()) {
+        m_crossfadeNextUrl.clear();
+        m_crossfadeStartTimer.stop();
+    } else if (m_queueSongId) {
+        // 地址还没到，播放列表里还没有这一项
+        m_queueSongId = 0;
+        m_queueResolving = false;
+        m_queueResolveTimer.stop();
+        m_queueAtEof = false;
+    } else {
+        const char *args[] = {"playlist-remove", "1", nullptr};
+        commandAsync(args);
+    }
+    m_hasQueued = false;
+}
+
+quint64 MPVPlayer::play()
+{
+    if (!m_mpv) return 0;
+    // 测量从继续播放到 mpv 报告位置前进的延迟
+    if (m_fileLoaded && m_paused && m_clock.isValid()) {
+        m_latencyStartSec = m_clock.positionSec();
+        m_latencyTimer.start();
+        m_measuringLatency = true;
+    }
     int paused = 0;
-    mpv_set_property(m_mpv, "pause", MPV_FORMAT_FLAG, &paused);
-    m_playing = true;
-    emit stateChanged(true);
+    // 淡变期间两个内核一起暂停/继续
+    if (m_fading) setPropertyAsync(m_mpvAux, "pause", MPV_FORMAT_FLAG, &paused);
+    return setPropertyAsync("pause", MPV_FORMAT_FLAG, &paused);
 }
 
-void MPVPlayer::pause()
+quint64 MPVPlayer::pause()
 {
-    if (!m_mpv) return;
+    if (!m_mpv) return 0;
     int paused = 1;
-    mpv_set_property(m_mpv, "pause", MPV_FORMAT_FLAG, &paused);
-    m_playing = false;
-    emit stateChanged(false);
+    if (m_fading) setPropertyAsync(m_mpvAux, "pause", MPV_FORMAT_FLAG, &paused);
+    return setPropertyAsync("pause", MPV_FORMAT_FLAG, &paused);
 }
 
-void MPVPlayer::stop()
+quint64 MPVPlayer::stop()
 {
-    if (!m_mpv) return;
+    if (!m_mpv) return 0;
+    m_crossfadeNextUrl.clear();
+    m_crossfadeStartTimer.stop();
+    if (m_fading) finishCrossfade();
     const char *cmd[] = {"stop", nullptr};
-    mpv_command(m_mpv, cmd);
-    m_playing = false;
-    emit stateChanged(false);
+    return commandAsync(cmd);
 }
 
-void MPVPlayer::setVolume(int vol)
+quint64 MPVPlayer::setVolume(int vol)
 {
-    if (!m_mpv) return;
+    if (!m_mpv) return 0;
+    m_volume = vol;
+    // 淡变期间音量由 onFadeTick 按比例下发
+    if (m_fading) return 0;
     double v = vol;
-    mpv_set_property(m_mpv, "volume", MPV_FORMAT_DOUBLE, &v);
+    return setPropertyAsync("volume", MPV_FORMAT_DOUBLE, &v);
+}
+
+quint64 MPVPlayer::setPosition(qint64 ms)
+{
+    if (!m_mpv) return 0;
+    return requestSeek(ms, true);
 }
 
-void MPVPlayer::setPosition(qint64 ms)
+// speed 是全局属性，换曲后保持；播放时钟通过观察 speed 属性同步
+void MPVPlayer::setSpeed(double speed)
 {
     if (!m_mpv) return;
-    double sec = ms / 1000.0;
-    mpv_set_property(m_mpv, "time-pos", MPV_FORMAT_DOUBLE, &sec);
+    setPropertyAsync("speed", MPV_FORMAT_DOUBLE, &speed);
+}
+
+void MPVPlayer::beginScrub()
+{
+    m_scrubbing = true;
+}
+
+void MPVPlayer::scrubTo(qint64 ms)
+{
+    if (!m_mpv) return;
+    // 拖动中只做关键帧 seek，网络流上比精确 seek 少很多 range 请求
+    if (m_scrubbing) {
+        requestSeek(preferCachedTarget(ms), false);
+    } else {
+        requestSeek(ms, true);
+    }
+}
+
+void MPVPlayer::endScrub(qint64 ms)
+{
+    m_scrubbing = false;
+    if (!m_mpv) return;
+    requestSeek(ms, true);
+}
+
+/*-------------------------------
+ * seek 合并：有 seek 在途时只记录最新目标，
+ * 等上一个完成（PLAYBACK_RESTART）后再发，避免请求堆积
+ *------------------------------*/
+quint64 MPVPlayer::requestSeek(qint64 ms, bool exact)
+{
+    if (exact) reportSeekStall(ms);
+    m_pendingSeekMs = ms;
+    m_pendingSeekExact = exact;
+    if (m_seekInFlight) return 0;
+    return issuePendingSeek();
+}
+
+quint64 MPVPlayer::issuePendingSeek()
+{
+    if (m_pendingSeekMs < 0) return 0;
+
+    QByteArray target = QByteArray::number(m_pendingSeekMs / 1000.0, 'f', 3);
+    const char *flags = m_pendingSeekExact ? "absolute+exact" : "absolute+keyframes";
+    const char *args[] = {"seek", target.constData(), flags, nullptr};
+
+    m_inFlightExact = m_pendingSeekExact;
+    // seek 期间时钟停在目标位置，等 PLAYBACK_RESTART 后再走
+    m_clock.sync(m_pendingSeekMs / 1000.0, mpv_get_time_us(m_mpv));
+    m_pendingSeekMs = -1;
+    m_seekInFlight = true;
+    m_seekTimer.start();
+    updateClockRunning(mpv_get_time_us(m_mpv));
+    m_seekRequestId = commandAsync(args);
+    return m_seekRequestId;
+}
+
+bool MPVPlayer::isBuffered(qint64 ms) const
+{
+    for (const BufferedRange &r : m_bufferedRanges) {
+        if (ms >= r.startMs && ms <= r.endMs) return true;
+    }
+    return false;
+}
+
+qint64 MPVPlayer::preferCachedTarget(qint64 ms) const
+{
+    if (isBuffered(ms)) return ms;
+    for (const BufferedRange &r : m_bufferedRanges) {
+        if (ms > r.endMs && ms - r.endMs <= kSnapToCacheMs) return r.endMs;
+    }
+    return ms;
+}
+
+/*-------------------------------
+ * 目标不在缓存里时估计卡顿：起播前要下载 kRefillSec 秒音频，
+ * 按当前码率和网络速率换算
+ *------------------------------*/
+void MPVPlayer::reportSeekStall(qint64 ms)
+{
+    if (m_bufferedRanges.isEmpty() || isBuffered(ms)) return;
+
+    qint64 stallMs = -1;
+    if (m_inputRate > 0 && m_audioBitrate > 0) {
+        double bytes = m_audioBitrate / 8 * kRefillSec;
+        stallMs = qint64(bytes / m_inputRate * 1000);
+    }
+    emit seekWillStall(ms, stallMs);
+}
+
+void MPVPlayer::updateBufferedRanges()
+{
+    MpvCacheState state = m_channel->cacheState();
+    m_inputRate = state.rawInputRate;
+
+    QVector<BufferedRange> ranges;
+    ranges.reserve(state.seekableRanges.size());
+    for (const auto &r : state.seekableRanges) {
+        ranges.append(BufferedRange{qint64(r.first * 1000), qint64(r.second * 1000)});
+    }
+    if (ranges != m_bufferedRanges) {
+        m_bufferedRanges = ranges;
+        emit bufferedRangesChanged(m_bufferedRanges);
+    }
+}
+
+void MPVPlayer::onStallTimeout()
+{
+    if (!m_fileLoaded) return;
+    qint64 resumeMs = m_clock.isValid() ? m_clock.positionMs() : qMax<qint64>(0, m_lastPositionMs);
+    qWarning() << "stream stalled for" << kStallTimeoutMs << "ms at" << resumeMs;
+    emit streamFailed(resumeMs, true);
+}
+
+void MPVPlayer::finishSeek()
+{
+    if (!m_seekInFlight) return;
+    m_seekInFlight = false;
+    m_seekRequestId = 0;
+    issuePendingSeek();
+}
+
+void MPVPlayer::setCrossfade(double seconds)
+{
+    m_crossfadeSec = qMax(0.0, seconds);
+    if (m_crossfadeSec > 0 && !m_mpvAux) {
+        m_mpvAux = createCore();
+        m_auxChannel = attachCore(m_mpvAux);
+    }
+    armCrossfade();
+}
+
+/*-------------------------------
+ * 按播放时钟计算淡入淡出起点，用单次定时器触发；
+ * 时钟每次变化（seek/暂停/变速/新位置）都会重新计算
+ *------------------------------*/
+void MPVPlayer::armCrossfade()
+{
+    if (m_crossfadeSec <= 0 || m_crossfadeNextUrl.isEmpty() || m_fading
+            || !m_clock.isValid() || !m_clock.isRunning() || playEndSec(m_mpv, m_clock) <= 0) {
+        m_crossfadeStartTimer.stop();
+        return;
+    }
+
+    double endSec = playEndSec(m_mpv, m_clock);
+    double fade = qMin(m_crossfadeSec, endSec / 2);
+    double untilSec = (endSec - fade - m_clock.positionSec()) / qMax(0.01, m_clock.speed());
+    m_crossfadeStartTimer.start(qMax(0, int(untilSec * 1000)));
+}
+
+void MPVPlayer::startCrossfade()
+{
+    if (m_crossfadeNextUrl.isEmpty() || !m_mpvAux || m_fading) return;
+
+    // 交换内核：空闲内核变为当前，原内核进入淡出
+    qSwap(m_mpv, m_mpvAux);
+    qSwap(m_channel, m_auxChannel);
+    m_fadeOutClock = m_clock;
+    m_fadeOutEndSec = playEndSec(m_mpvAux, m_fadeOutClock);
+    m_clock = PlaybackClock(m_mpv);
+
+    // 新内核上的状态从头开始
+    m_fileLoaded = false;
+    m_pendingLoadId = 0;
+    m_pendingSeekMs = -1;
+    m_seekInFlight = false;
+    m_seekRequestId = 0;
+    m_lastPositionMs = -1;
+    m_fading = true;
+
+    QString url = m_crossfadeNextUrl;
+    m_crossfadeNextUrl.clear();
+    m_hasQueued = false;
+
+    applyDeckVolume(m_mpv, 0.0);
+    m_loadTimer.start();
+    m_awaitingFirstAudio = true;
+    int paused = 0;
+    setPropertyAsync("pause", MPV_FORMAT_FLAG, &paused);
+    QByteArray u = url.toUtf8();
+    const char *args[] = {"loadfile", u.constData(), "replace", nullptr};
+    m_pendingLoadId = commandAsync(args);
+
+    m_fadeTimer.start();
+    emit trackAdvanced();
+}
+
+/*-------------------------------
+ * 淡变进度取自淡出内核的播放时钟（剩余时间 / 淡变时长），
+ * 等功率曲线，两个内核音量之和听感恒定
+ *------------------------------*/
+void MPVPlayer::onFadeTick()
+{
+    if (!m_fading) return;
+
+    double fade = qMax(0.001, qMin(m_crossfadeSec > 0 ? m_crossfadeSec : 1.0, m_fadeOutEndSec / 2));
+    double remaining = m_fadeOutEndSec - m_fadeOutClock.positionSec();
+    double progress = qBound(0.0, 1.0 - remaining / fade, 1.0);
+
+    // 新曲目尚未出声时保持静音，不提前把旧曲目压下去
+    if (!m_clock.isRunning() && progress < 1.0) {
+        return;
+    }
+
+    applyDeckVolume(m_mpvAux, qCos(progress * M_PI / 2));
+    applyDeckVolume(m_mpv, qSin(progress * M_PI / 2));
+
+    if (progress >= 1.0) {
+        finishCrossfade();
+    }
+}
+
+void MPVPlayer::finishCrossfade()
+{
+    if (!m_fading) return;
+    m_fading = false;
+    m_fadeTimer.stop();
+
+    const char *cmd[] = {"stop", nullptr};
+    commandAsync(m_mpvAux, cmd);
+    applyDeckVolume(m_mpv, 1.0);
+    updatePlaying();
+}
+
+void MPVPlayer::applyDeckVolume(mpv_handle *mpv, double gain)
+{
+    double v = m_volume * gain;
+    setPropertyAsync(mpv, "volume", MPV_FORMAT_DOUBLE, &v);
 }
 
 bool MPVPlayer::isPlaying() const
@@ -103,45 +992,288 @@ bool MPVPlayer::isPlaying() const
     return m_playing;
 }
 
-void MPVPlayer::onPoll()
+/*-------------------------------
+ * 异步请求：mpv 会拷贝参数，调用后立即返回
+ * 同步失败（参数错误等）也走 requestFailed，调用方只需处理一种路径
+ *------------------------------*/
+quint64 MPVPlayer::commandAsync(mpv_handle *mpv, const char **args)
 {
-    if (!m_mpv) return;
+    quint64 id = m_nextRequestId++;
+    int r = mpv_command_async(mpv, id, args);
+    if (r < 0) {
+        emit requestFailed(id, r, QString::fromUtf8(mpv_error_string(r)));
+    }
+    return id;
+}
+
+quint64 MPVPlayer::setPropertyAsync(mpv_handle *mpv, const char *name, mpv_format format, void *data)
+{
+    quint64 id = m_nextRequestId++;
+    int r = mpv_set_property_async(mpv, id, name, format, data);
+    if (r < 0) {
+        emit requestFailed(id, r, QString::fromUtf8(mpv_error_string(r)));
+    }
+    return id;
+}
 
-    /* ===== 1. 处理 mpv 事件 ===== */
-    while (true) {
-        mpv_event *event = mpv_wait_event(m_mpv, 0);
-        if (event->event_id == MPV_EVENT_NONE)
-            break;
+// 单次最多处理的事件数，剩余的留到下一轮，避免长时间占用 GUI 线程
+static const int kMaxEventsPerBatch = 256;
 
-        if (event->event_id == MPV_EVENT_END_FILE) {
-            mpv_event_end_file *end =
-                (mpv_event_end_file *)event->data;
+void MPVPlayer::onMpvEvents()
+{
+    // 先确认再取事件，取事件期间新到达的事件会重新通知
+    m_channel->acknowledge();
+    if (m_auxChannel) m_auxChannel->acknowledge();
 
-            // 正常播放结束（不是 error / user stop）
-            if (end->reason == MPV_END_FILE_REASON_EOF) {
-                emit playbackFinished();
-            }
+    MpvEventRecord rec;
+    int handled = 0;
+    while (handled < kMaxEventsPerBatch && m_channel->pop(rec)) {
+        handleEvent(rec);
+        ++handled;
+    }
+    while (m_auxChannel && handled < kMaxEventsPerBatch && m_auxChannel->pop(rec)) {
+        handleFadingEvent(rec);
+        ++handled;
+    }
+
+    if (handled == kMaxEventsPerBatch) {
+        QMetaObject::invokeMethod(this, "onMpvEvents", Qt::QueuedConnection);
+    }
+
+    // 时钟可能已变化，重新计算淡入淡出起点和预排曲目的解析时间
+    if (m_crossfadeSec > 0) armCrossfade();
+    if (m_queueSongId && !m_queueResolving) armQueueResolve();
+}
+
+void MPVPlayer::handleEvent(const MpvEventRecord &rec)
+{
+    switch (rec.id) {
+    case MPV_EVENT_PROPERTY_CHANGE:
+        handlePropertyChange(rec);
+        break;
+
+    case MPV_EVENT_COMMAND_REPLY:
+    case MPV_EVENT_SET_PROPERTY_REPLY:
+        handleReply(rec);
+        break;
+
+    case MPV_EVENT_GET_PROPERTY_REPLY:
+        handleMeterReply(rec);
+        break;
+
+    case MPV_EVENT_HOOK:
+        handleLoadHook(m_mpv, rec);
+        break;
+
+    case MPV_EVENT_PLAYBACK_RESTART:
+        // 加载后第一次 restart：开始出声
+        if (m_awaitingFirstAudio && m_fileLoaded) {
+            m_awaitingFirstAudio = false;
+            emit firstAudio(m_loadTimer.elapsed());
+        }
+        // seek 真正完成（新位置开始出声/就绪）
+        if (m_seekInFlight) {
+            emit seekCompleted(m_seekTimer.elapsed(), m_inFlightExact);
+            finishSeek();
+        }
+        updateClockRunning(rec.timeUs);
+        break;
+
+    case MPV_EVENT_START_FILE:
+        m_fileLoaded = false;
+        m_clock.reset();
+        m_audioBitrate = 0.0;
+        if (!m_bufferedRanges.isEmpty()) {
+            m_bufferedRanges.clear();
+            emit bufferedRangesChanged(m_bufferedRanges);
+        }
+        updatePlaying();
+        break;
+
+    case MPV_EVENT_FILE_LOADED:
+        m_fileLoaded = true;
+        updatePlaying();
+        updateClockRunning(rec.timeUs);
+        break;
+
+    case MPV_EVENT_END_FILE: {
+        m_stallTimer.stop();
+        // 播放中途出错（断网、地址过期）：带上断点交给上层续播
+        if (rec.endReason == MPV_END_FILE_REASON_ERROR) {
+            qint64 resumeMs = m_clock.isValid() ? m_clock.positionMs() : qMax<qint64>(0, m_lastPositionMs);
+            qWarning() << "stream error:" << mpv_error_string(rec.error) << "at" << resumeMs;
+            emit streamFailed(resumeMs, false);
+        }
+        m_fileLoaded = false;
+        updatePlaying();
+        // 加载失败不统计（被替换的旧文件结束原因是 STOP，不影响新文件计时）
+        if (rec.endReason == MPV_END_FILE_REASON_ERROR) m_awaitingFirstAudio = false;
+        // 文件结束后旧的 seek 目标已无意义
+        m_pendingSeekMs = -1;
+        m_seekInFlight = false;
+        m_seekRequestId = 0;
+        updateClockRunning(rec.timeUs);
+        // 正常播放结束（不是 error / user stop）；有预排曲目时 mpv 会自己接上
+        if (rec.endReason == MPV_END_FILE_REASON_EOF && !m_hasQueued) {
+            emit playbackFinished();
+        } else if (rec.endReason == MPV_END_FILE_REASON_EOF && m_queueSongId) {
+            // 预排曲目的地址还没排进播放列表（短曲目、拖到末尾、解析慢）：
+            // 立即解析，到达后在 appendQueued 里直接加载
+            m_queueAtEof = true;
+            m_queueResolveTimer.stop();
+            resolveQueued();
         }
+        break;
     }
 
-    /* ===== 2. 原有进度轮询 ===== */
-    double timePos = 0.0;
-    if (mpv_get_property(m_mpv, "time-pos", MPV_FORMAT_DOUBLE, &timePos) >= 0) {
-        emit positionChanged(qint64(timePos * 1000));
+    default:
+        break;
     }
+}
+
+/*-------------------------------
+ * 第二个内核的事件：淡出期间只关心它的位置和结束，
+ * 其余（包括空闲时）只转发请求结果
+ *------------------------------*/
+void MPVPlayer::handleFadingEvent(const MpvEventRecord &rec)
+{
+    switch (rec.id) {
+    case MPV_EVENT_COMMAND_REPLY:
+    case MPV_EVENT_SET_PROPERTY_REPLY:
+        handleReply(rec);
+        break;
+
+    case MPV_EVENT_GET_PROPERTY_REPLY:
+        // 读取后内核发生了交换，只需放行下一次读取
+        if (rec.replyUserdata == m_meterRequestId) m_meterRequestId = 0;
+        break;
+
+    case MPV_EVENT_HOOK:
+        // 钩子必须放行，否则该内核会一直卡住
+        handleLoadHook(m_mpvAux, rec);
+        break;
+
+    case MPV_EVENT_PROPERTY_CHANGE:
+        if (!m_fading || !rec.hasValue) break;
+        if (rec.replyUserdata == PropTimePos) {
+            m_fadeOutClock.sync(rec.value, rec.timeUs);
+        } else if (rec.replyUserdata == PropPause) {
+            m_fadeOutClock.setRunning(rec.value == 0, rec.timeUs);
+        }
+        break;
 
-    double duration = 0.0;
-    if (mpv_get_property(m_mpv, "duration", MPV_FORMAT_DOUBLE, &duration) >= 0) {
-        emit durationChanged(qint64(duration * 1000));
+    case MPV_EVENT_END_FILE:
+        // 旧曲目提前结束（比如时长不准），直接完成淡变
+        if (m_fading) {
+            m_fadeOutClock.setRunning(false, rec.timeUs);
+            applyDeckVolume(m_mpv, 1.0);
+            finishCrossfade();
+        }
+        break;
+
+    default:
+        break;
     }
+}
 
-    int paused = 1;
-    if (mpv_get_property(m_mpv, "pause", MPV_FORMAT_FLAG, &paused) >= 0) {
-        bool playing = (paused == 0);
-        if (playing != m_playing) {
-            m_playing = playing;
-            emit stateChanged(m_playing);
+void MPVPlayer::handlePropertyChange(const MpvEventRecord &rec)
+{
+    // 属性不可用（如未加载文件）时没有值
+    if (!rec.hasValue) return;
+
+    switch (rec.replyUserdata) {
+    case PropTimePos: {
+        // seek 在途时 mpv 可能还会报旧位置，不用它覆盖目标
+        if (!m_seekInFlight) {
+            m_clock.sync(rec.value, rec.timeUs);
+        }
+        if (m_measuringLatency && !m_paused && rec.value > m_latencyStartSec) {
+            m_measuringLatency = false;
+            emit outputLatencyMeasured(m_latencyTimer.elapsed());
+        }
+        qint64 ms = qint64(rec.value * 1000);
+        if (ms != m_lastPositionMs) {
+            m_lastPositionMs = ms;
+            emit positionChanged(ms);
+        }
+        break;
+    }
+    case PropDuration:
+        m_clock.setDuration(rec.value);
+        emit durationChanged(qint64(rec.value * 1000));
+        break;
+    case PropPause:
+        m_paused = (rec.value != 0);
+        updatePlaying();
+        updateClockRunning(rec.timeUs);
+        break;
+    case PropSpeed:
+        m_clock.setSpeed(rec.value, rec.timeUs);
+        break;
+    case PropCacheState:
+        updateBufferedRanges();
+        break;
+    case PropAudioBitrate:
+        m_audioBitrate = rec.value;
+        break;
+    case PropAudioDeviceList:
+        m_audioDevices = m_channel->audioDevices();
+        emit audioDevicesChanged(m_audioDevices);
+        break;
+    case PropPausedForCache:
+        // 正常缓冲很快恢复；只在持续卡住时才当作断流
+        if (rec.value != 0) m_stallTimer.start();
+        else m_stallTimer.stop();
+        break;
+    case PropPlaylistPos:
+        // 列表位置前进说明已切到预排曲目：清掉播完的一项，列表位置回到 0
+        if (rec.value >= 1) {
+            m_hasQueued = false;
+            // 预排项的裁剪终点随 loadfile 选项生效，这里同步给淡入淡出计算用
+            if (m_queueTrimEndSec > 0) m_trimEndSec.insert(m_mpv, m_queueTrimEndSec);
+            else m_trimEndSec.remove(m_mpv);
+            m_queueTrimEndSec = 0.0;
+            const char *args[] = {"playlist-clear", nullptr};
+            commandAsync(args);
+            emit trackAdvanced();
         }
+        break;
+    default:
+        break;
     }
 }
 
+void MPVPlayer::handleReply(const MpvEventRecord &rec)
+{
+    if (rec.replyUserdata == m_pendingLoadId) {
+        m_pendingLoadId = 0;
+    }
+
+    // seek 被拒绝（如未加载文件）时不会有 PLAYBACK_RESTART，这里放行下一个
+    if (rec.replyUserdata == m_seekRequestId && rec.error < 0) {
+        finishSeek();
+        updateClockRunning(rec.timeUs);
+    }
+
+    if (rec.error < 0) {
+        emit requestFailed(rec.replyUserdata, rec.error, QString::fromUtf8(mpv_error_string(rec.error)));
+    } else {
+        emit requestFinished(rec.replyUserdata);
+    }
+}
+
+void MPVPlayer::updateClockRunning(qint64 timeUs)
+{
+    m_clock.setRunning(m_fileLoaded && !m_paused && !m_seekInFlight, timeUs);
+}
+
+void MPVPlayer::updatePlaying()
+{
+    // 淡变时新曲目还在加载，旧曲目仍在出声，视为播放中
+    bool playing = (m_fileLoaded || m_fading) && !m_paused;
+    if (playing != m_playing) {
+        m_playing = playing;
+        emit stateChanged(m_playing);
+    }
+    updateMeterTimer();
+}
@@ -7,46 +7,228 @@
 #define MPVPLAYER_H
 
 #include <QObject>
-#include <QTimer>
 #include <QString>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QVector>
+#include <QMultiHash>
+#include <QList>
 #include <mpv/client.h>
+#include "audioplayer.h"
+#include "mpveventloop.h"
+#include "playbackclock.h"
 
-enum PlayMode {
-    PlaySequence,   // 顺序播放
-    PlayRandom,     // 随机播放
-    PlaySingleLoop  // 单曲循环
-};
-
+class AudioChunkCache;
 
-class MPVPlayer : public QObject
+class MPVPlayer : public AudioPlayer
 {
     Q_OBJECT
 public:
     explicit MPVPlayer(QObject *parent = nullptr);
     ~MPVPlayer();
 
-    void playUrl(const QString &url); // 加载并播放（替换当前）
-    void play();
-    void pause();
-    void stop();
-    void setVolume(int vol); // 0-100
-    void setPosition(qint64 ms); // 毫秒
+    // 以下接口全部异步，立即返回请求 id，结果通过 requestFinished / requestFailed 通知
+    // 加载并播放（替换当前，旧的加载请求会被中止）；startMs >= 0 时从该位置开始（断线续播）
+    quint64 playUrl(const QString &url, qint64 startMs = -1);
+    quint64 queueNext(const QString &url); // 预排下一首（mpv 内部播放列表 + 预读），无缝衔接
+
+    // 按歌曲 id 播放：地址在 mpv 真正加载时才通过 songUrlRequested 解析，不会过期
+    static QString songUrl(int songId);
+    quint64 playSong(int songId, qint64 startMs = -1) override { return playUrl(songUrl(songId), startMs); }
+    // 预排：当前曲目结束前先解析地址，再把解析好的地址排进播放列表，mpv 才能提前预读
+    quint64 queueNextSong(int songId) override;
+    // 解析结果；url 为空表示失败
+    void provideSongUrl(int songId, const QString &url, double gainDb = 0.0,
+                        const TrackTrim &trim = TrackTrim()) override;
+
+    // 设置后按 id 播放的歌曲都经由分块缓存读取（mcache://），重播不再走网络
+    void setChunkCache(AudioChunkCache *cache);
+
+    void clearQueue() override;
+    bool hasQueued() const { return m_hasQueued; }
+    quint64 play() override;
+    quint64 pause() override;
+    quint64 stop() override;
+    quint64 setVolume(int vol) override; // 0-100
+    quint64 setPosition(qint64 ms) override; // 毫秒，精确 seek；已有 seek 在途时合并，返回 0
+    void setSpeed(double speed) override;
+
+    // 淡入淡出：> 0 时预排曲目不进 mpv 播放列表，而是在结束前 seconds 秒于第二个内核上启动
+    void setCrossfade(double seconds) override;
+    double crossfade() const { return m_crossfadeSec; }
+    bool isCrossfading() const { return m_fading; }
+
+    // 拖动模式：拖动中只保留最新目标并做关键帧快速 seek，松手时做一次精确 seek
+    // 拖动中会优先落在已缓存区间附近（见 preferCachedTarget）
+    void beginScrub() override;
+    void scrubTo(qint64 ms) override;
+    void endScrub(qint64 ms) override;
+    bool isScrubbing() const { return m_scrubbing; }
+
+    QVector<BufferedRange> bufferedRanges() const override { return m_bufferedRanges; }
+    bool isBuffered(qint64 ms) const;
+
+    // 音频输出：设备列表来自 audio-device-list（热插拔会更新），名称 "auto" 为系统默认
+    QList<MpvAudioDevice> audioDevices() const override { return m_audioDevices; }
+    QString audioDevice() const override { return m_audioDevice; }
+    void setAudioDevice(const QString &name) override;
+    // 低延迟输出：小缓冲 + PipeWire/Pulse 延迟提示，切换后重建音频输出
+    void setLowLatency(bool enabled) override;
+    bool isLowLatency() const override { return m_lowLatency; }
+
+    // DSP 链（见 DspSettings），两个淡入淡出内核同步修改
+    void setDsp(const DspSettings &dsp) override;
+    DspSettings dsp() const override { return m_dsp; }
+
+    // 电平表：测量滤镜挂在 af 链末尾，读数随帧写进 af-metadata，按 kMeterIntervalMs 异步读取
+    void setMetering(bool enabled) override;
+    bool isMetering() const override { return m_metering; }
+
+    bool isPlaying() const override; // 文件已加载且未暂停（以 mpv 确认为准）
 
-    bool isPlaying() const;
+    // 纯音频快速启动配置，必须在 mpv_initialize 之前调用（分析用的无头内核也复用）
+    static void applyAudioOnlyProfile(mpv_handle *mpv);
 
-signals:
-    void positionChanged(qint64 ms);
-    void durationChanged(qint64 ms);
-    void stateChanged(bool playing);
-    void playbackFinished();
+    // 高精度播放时钟：按帧率读取外推位置，不产生 mpv 往返
+    const PlaybackClock &clock() const { return m_clock; }
+    qint64 positionMs() const override { return m_clock.positionMs(); }
+    qint64 durationMs() const override { return qint64(m_clock.durationSec() * 1000); }
 
 private slots:
-    void onPoll(); // 定时器轮询属性
+    void onMpvEvents(); // 批量处理事件线程交过来的 mpv 事件
+    void startCrossfade();
+    void onFadeTick();
+    void onStallTimeout();
+    void pollMeters();
+    void resolveQueued();
 
 private:
-    mpv_handle *m_mpv;
-    QTimer m_pollTimer;
+    // mpv_observe_property 的 reply_userdata，用于区分属性
+    enum ObservedProperty {
+        PropTimePos = 1,
+        PropDuration,
+        PropPause,
+        PropSpeed,
+        PropPlaylistPos,
+        PropCacheState,
+        PropAudioBitrate,
+        PropPausedForCache,
+        PropAudioDeviceList
+    };
+
+    mpv_handle *createCore();
+    MpvEventChannel *attachCore(mpv_handle *mpv);
+    void destroyCore(mpv_handle *mpv, MpvEventChannel *channel);
+
+    void handleEvent(const MpvEventRecord &rec);
+    void handleFadingEvent(const MpvEventRecord &rec); // 正在淡出的内核
+    void handlePropertyChange(const MpvEventRecord &rec);
+    void handleReply(const MpvEventRecord &rec);
+    void handleLoadHook(mpv_handle *mpv, const MpvEventRecord &rec);
+    void continueHook(int songId, quint64 hookId, const QString &url, double gainDb, const TrackTrim &trim);
+    void applyTrim(mpv_handle *mpv, const TrackTrim &trim);
+    double playEndSec(mpv_handle *mpv, const PlaybackClock &clock) const;
+    void updatePlaying();
+    void updateClockRunning(qint64 timeUs);
+    void armQueueResolve();
+    void appendQueued(const QString &url, double gainDb, const TrackTrim &trim);
+    quint64 requestSeek(qint64 ms, bool exact);
+    quint64 issuePendingSeek();
+    void finishSeek();
+    qint64 preferCachedTarget(qint64 ms) const;
+    void reportSeekStall(qint64 ms);
+    void updateBufferedRanges();
+    void armCrossfade();
+    void finishCrossfade();
+    void applyDeckVolume(mpv_handle *mpv, double gain);
+    void applyOutputSettings(mpv_handle *mpv);
+    void applyAudioFilters(mpv_handle *mpv); // 重建整个 af 链，只在开关变化/新内核时调用
+    QByteArray dspGraph() const;
+    void sendDspCommand(const char *command, double value, const QByteArray &target);
+    static QByteArray meterGraph();
+    void updateMeterTimer();
+    void handleMeterReply(const MpvEventRecord &rec);
+
+    quint64 commandAsync(const char **args) { return commandAsync(m_mpv, args); }
+    quint64 setPropertyAsync(const char *name, mpv_format format, void *data)
+    { return setPropertyAsync(m_mpv, name, format, data); }
+    quint64 commandAsync(mpv_handle *mpv, const char **args);
+    quint64 setPropertyAsync(mpv_handle *mpv, const char *name, mpv_format format, void *data);
+
+    mpv_handle *m_mpv;         // 当前（对外）内核，所有命令和状态都针对它
+    MpvEventChannel *m_channel; // 共享事件线程交过来的事件
+    mpv_handle *m_mpvAux;      // 第二个内核，仅淡入淡出时创建；淡出期间就是正在淡出的那个
+    MpvEventChannel *m_auxChannel;
     bool m_playing;
+    bool m_fileLoaded;     // 收到 FILE_LOADED 之后才认为在播放
+    bool m_paused;
+    quint64 m_nextRequestId;
+    quint64 m_pendingLoadId; // 尚未完成的 loadfile 请求，0 表示没有
+    bool m_hasQueued;        // mpv 播放列表里当前曲目之后是否还有一首（含等待地址的）
+    int m_queueSongId;       // 已预排但地址还没排进播放列表的曲目，0 表示没有
+    bool m_queueResolving;   // 已为它请求地址
+    QTimer m_queueResolveTimer;
+    double m_queueTrimEndSec; // 已排进播放列表的预排项的裁剪终点（秒），0 表示没有
+    bool m_queueAtEof;       // 当前曲目已播完，预排曲目的地址还没到
+    qint64 m_lastPositionMs;
+
+    // seek 合并状态：同一时间最多一个 seek 在途，其余只保留最新目标
+    bool m_scrubbing;
+    bool m_seekInFlight;
+    bool m_inFlightExact;
+    quint64 m_seekRequestId;
+    qint64 m_pendingSeekMs;   // -1 表示没有待发 seek
+    bool m_pendingSeekExact;
+    QElapsedTimer m_seekTimer;
+
+    // 缓存状态（来自 demuxer-cache-state）
+    QVector<BufferedRange> m_bufferedRanges;
+    qint64 m_inputRate;     // 字节/秒
+    double m_audioBitrate;  // 比特/秒
+    QTimer m_stallTimer;    // paused-for-cache 持续过久视为断流
+
+    // 等待地址的 on_load 钩子（歌曲 id -> 钩子）
+    struct PendingHook {
+        mpv_handle *mpv;
+        quint64 hookId;
+    };
+    QMultiHash<int, PendingHook> m_pendingHooks;
+    // 各内核当前文件的裁剪终点（秒），淡入淡出按它而不是时长计算
+    QHash<mpv_handle *, double> m_trimEndSec;
+
+    AudioChunkCache *m_chunkCache;
+
+    // 音频输出
+    QList<MpvAudioDevice> m_audioDevices;
+    QString m_audioDevice;
+    bool m_lowLatency;
+    QHash<QByteArray, QByteArray> m_defaultOutputOptions; // 关闭低延迟时恢复
+    QElapsedTimer m_latencyTimer;
+    bool m_measuringLatency;
+    double m_latencyStartSec;
+
+    DspSettings m_dsp;
+
+    // 电平表
+    bool m_metering;
+    QTimer m_meterTimer;       // 只在电平表打开且正在播放时运行
+    quint64 m_meterRequestId;  // 在途的 af-metadata 读取，0 表示没有
+
+    PlaybackClock m_clock;
+
+    // 首次出声耗时统计：playUrl 开始计时，加载后的第一次 PLAYBACK_RESTART 结束
+    QElapsedTimer m_loadTimer;
+    bool m_awaitingFirstAudio;
+
+    // 淡入淡出状态
+    int m_volume;                // 用户音量 0-100，淡入淡出按比例缩放
+    double m_crossfadeSec;
+    QString m_crossfadeNextUrl;  // 等待在淡入淡出点启动的下一首
+    QTimer m_crossfadeStartTimer; // 按播放时钟计算的单次定时器
+    QTimer m_fadeTimer;          // 仅在淡变期间运行
+    bool m_fading;
+    PlaybackClock m_fadeOutClock; // 淡出内核的时钟
+    double m_fadeOutEndSec;       // 淡出曲目的结束位置
 };
 
 #endif // MPVPLAYER_H
@@ -4,6 +4,7 @@
  * @date    : 2025.12.12
  **/
 #include "networkmanager.h"
+#include "searchlistparser.h"
 #include <QNetworkReply>
 #include <QNetworkRequest>
 #include <QUrlQuery>
@@ -12,11 +13,37 @@
 #include <QJsonArray>
 #include <QBuffer>
 
-NetworkManager::NetworkManager(QObject *parent)
-    : QObject(parent),
+NetworkManager::NetworkManager()
+    : QObject(nullptr),
       m_mgr(new QNetworkAccessManager(this))
 {
+    qRegisterMetaType<QList<NetworkManager::SearchItem>>();
+    qRegisterMetaType<NetworkManager::UrlResult>();
+
     connect(m_mgr, &QNetworkAccessManager::finished, this, &NetworkManager::onReplyFinished);
+    // manager 和未完成的 reply 要在它们所在的 I/O 线程释放：线程退出前处理 deleteLater
+    connect(&m_thread, &QThread::finished, m_mgr, &QObject::deleteLater);
+    // manager 还没发过请求，随本对象一起移过去；之后只在 I/O 线程里使用
+    m_thread.setObjectName("NetworkManager");
+    moveToThread(&m_thread);
+    m_thread.start();
+}
+
+NetworkManager::~NetworkManager()
+{
+    // manager 在线程结束时已由 deleteLater 释放（见构造函数），之后析构的只有本对象
+    m_thread.quit();
+    m_thread.wait();
+}
+
+// 请求接口可能来自任何线程，统一排队到 I/O 线程执行
+void NetworkManager::get(const QUrl &url)
+{
+    QMetaObject::invokeMethod(this, [this, url]() {
+        QNetworkRequest req(url);
+        req.setRawHeader("User-Agent", "QtMusicPlayer/1.0");
+        m_mgr->get(req);
+    }, Qt::QueuedConnection);
 }
 
 void NetworkManager::search(const QString &keyword)
@@ -32,9 +59,7 @@ void NetworkManager::search(const QString &keyword)
 
     }
     url.setQuery(q);
-    QNetworkRequest req(url);
-    req.setRawHeader("User-Agent", "QtMusicPlayer/1.0");
-    m_mgr->get(req);
+    get(url);
 }
 
 void NetworkManager::getUrlById(int id)
@@ -43,32 +68,36 @@ void NetworkManager::getUrlById(int id)
     QUrlQuery q;
     q.addQueryItem("id", QString::number(id));
     url.setQuery(q);
-    QNetworkRequest req(url);
-    req.setRawHeader("User-Agent", "QtMusicPlayer/1.0");
-    m_mgr->get(req);
+    get(url);
 }
 
-void NetworkManager::fetchImage(const QString &url)
+void NetworkManager::fetchImage(const QString &url, const QSize &size)
 {
-    if (url.isEmpty()) {
-        emit imageFetched(QPixmap());
-        return;
-    }
-    QNetworkRequest req(url);
-    req.setRawHeader("User-Agent", "QtMusicPlayer/1.0");
-    // 新建 manager 单次请求（避免与主 manager 混淆）
-    QNetworkAccessManager *mgr = new QNetworkAccessManager(this);
-    QNetworkReply *reply = mgr->get(req);
-    connect(reply, &QNetworkReply::finished, this, [reply, mgr, this]() {
-        QPixmap pix;
-        if (reply->error() == QNetworkReply::NoError) {
-            QByteArray data = reply->readAll();
-            pix.loadFromData(data);
+    QMetaObject::invokeMethod(this, [this, url, size]() {
+        if (url.isEmpty()) {
+            emit imageFetched(QImage());
+            return;
         }
-        emit imageFetched(pix);
-        reply->deleteLater();
-        mgr->deleteLater();
-    });
+        QNetworkRequest req(url);
+        req.setRawHeader("User-Agent", "QtMusicPlayer/1.0");
+        // 新建 manager 单次请求（避免与主 manager 混淆）
+        QNetworkAccessManager *mgr = new QNetworkAccessManager(this);
+        QNetworkReply *reply = mgr->get(req);
+        connect(reply, &QNetworkReply::finished, this, [reply, mgr, size, this]() {
+            // 解码和缩放都在 I/O 线程，界面线程只做 QImage -> QPixmap
+            QImage image;
+            if (reply->error() == QNetworkReply::NoError) {
+                QByteArray data = reply->readAll();
+                image.loadFromData(data);
+            }
+            if (!image.isNull() && size.isValid()) {
+                image = image.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+            }
+            emit imageFetched(image);
+            reply->deleteLater();
+            mgr->deleteLater();
+        });
+    }, Qt::QueuedConnection);
 }
 
 void NetworkManager::getHost()
@@ -76,9 +105,7 @@ void NetworkManager::getHost()
     QUrl url(QStringLiteral("https://a.buguyy.top/newapi/gethot.php?t=1"));
     QUrlQuery q;
     url.setQuery(q);
-    QNetworkRequest req(url);
-    req.setRawHeader("User-Agent", "QtMusicPlayer/1.0");
-    m_mgr->get(req);
+    get(url);
 }
 
 void NetworkManager::getNew()
@@ -86,43 +113,35 @@ void NetworkManager::getNew()
     QUrl url(QStringLiteral("https://a.buguyy.top/newapi/getnew.php?t=1"));
     QUrlQuery q;
     url.setQuery(q);
-    QNetworkRequest req(url);
-    req.setRawHeader("User-Agent", "QtMusicPlayer/1.0");
-    m_mgr->get(req);
+    get(url);
+}
+
+QNetworkReply *NetworkManager::getRaw(const QNetworkRequest &req)
+{
+    Q_ASSERT(QThread::currentThread() == thread());
+    QNetworkRequest r(req);
+    r.setAttribute(QNetworkRequest::User, true);
+    return m_mgr->get(r);
 }
 
 void NetworkManager::onReplyFinished(QNetworkReply *reply)
 {
     if (!reply) return;
+    // 原始请求由调用方处理
+    if (reply->request().attribute(QNetworkRequest::User).toBool()) return;
     QUrl url = reply->request().url();
     QByteArray body = reply->readAll();
     QString path = url.path();
 
     if (path.contains("search.php") || path.contains("gethot.php") || path.contains("getnew.php")) {
         QList<SearchItem> list;
-        QJsonParseError err;
-        QJsonDocument doc = QJsonDocument::fromJson(body, &err);
-        if (err.error == QJsonParseError::NoError && doc.isObject()) {
-            QJsonObject obj = doc.object();
-            if (obj.value("code").toInt() == 200) {
-                QJsonObject data = obj.value("data").toObject();
-                QJsonArray arr = data.value("list").toArray();
-                for (const QJsonValue &v : arr) {
-                    QJsonObject it = v.toObject();
-                    SearchItem si;
-                    si.id = it.value("id").toInt();
-                    si.title = it.value("title").toString();
-                    si.singer = it.value("singer").toString();
-                    si.picurl = it.value("picurl").toString();
-                    si.hit = it.value("hit").toInt();
-                    list.append(si);
-                }
-            }
-        }
+        // 列表可能上千条，按需扫描直接填 SearchItem，不建 DOM（见 SearchListParser）
+        SearchListParser::parse(body, list);
         emit searchFinished(list);
     }
     else if (path.contains("geturl2.php")) {
         UrlResult res;
+        res.id = QUrlQuery(url).queryItemValue("id").toInt();
         QJsonParseError err;
         QJsonDocument doc = QJsonDocument::fromJson(body, &err);
         if (err.error == QJsonParseError::NoError && doc.isObject()) {
@@ -1,5 +1,7 @@
 /**
- * @brief   : 网络模块，负责搜索、解析真实播放地址、以及加载封面图片
+ * @brief   : 网络模块，负责搜索、解析真实播放地址、以及加载封面图片。
+ *            整个对象（含 QNetworkAccessManager）运行在自己的 I/O 线程里，
+ *            JSON 解析和封面解码都在该线程完成，信号只带解析好的结果
  * @author  : 樊晓亮
  * @date    : 2025.12.12
  **/
@@ -8,13 +10,23 @@
 
 #include <QObject>
 #include <QNetworkAccessManager>
-#include <QPixmap>
+#include <QThread>
+#include <QImage>
+#include <QSize>
+#include <QMetaType>
 
+/*
+ * 对象在构造时移到内部线程，因此不能有父对象，由创建者负责 delete
+ * （析构时结束线程，须早于仍会调用它的对象，如分块缓存）。
+ * 公开的请求接口可以在任何线程调用，内部转到 I/O 线程执行；
+ * 信号在 I/O 线程发出，连到其他线程的对象时自动排队。
+ */
 class NetworkManager : public QObject
 {
     Q_OBJECT
 public:
-    explicit NetworkManager(QObject *parent = nullptr);
+    NetworkManager();
+    ~NetworkManager();
 
     struct SearchItem {
         int id;
@@ -25,6 +37,7 @@ public:
     };
 
     struct UrlResult {
+        int id = 0;   // 请求时的歌曲 id，用于区分并发的解析请求
         QString rid;
         QString name;
         QString artist;
@@ -39,20 +52,32 @@ public:
 
     void search(const QString &keyword);
     void getUrlById(int id);
-    void fetchImage(const QString &url); // 异步，将通过信号返回
+    // 异步，将通过信号返回；size 有效时在 I/O 线程里按比例缩小到该尺寸以内
+    void fetchImage(const QString &url, const QSize &size = QSize());
     void getHost();
     void getNew();
 
+    // 原始请求（如音频分块的 Range 请求），复用同一个连接池；
+    // 调用方自己处理 finished 并释放 reply，不经过 onReplyFinished 的解析。
+    // 只能在 I/O 线程（thread()）里调用，回调也应在该线程处理
+    QNetworkReply *getRaw(const QNetworkRequest &req);
+
 signals:
-    void searchFinished(const QList<SearchItem> &list);
-    void getUrlFinished(const UrlResult &res);
-    void imageFetched(const QPixmap &pix);
+    void searchFinished(const QList<NetworkManager::SearchItem> &list);
+    void getUrlFinished(const NetworkManager::UrlResult &res);
+    void imageFetched(const QImage &image); // 解码失败或地址为空时为空图
 
 private slots:
     void onReplyFinished(QNetworkReply *reply);
 
 private:
+    void get(const QUrl &url);
+
+    QThread m_thread;
     QNetworkAccessManager *m_mgr;
 };
 
+Q_DECLARE_METATYPE(NetworkManager::SearchItem)
+Q_DECLARE_METATYPE(NetworkManager::UrlResult)
+
 #endif // NETWORKMANAGER_H
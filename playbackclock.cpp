@@ -0,0 +1,78 @@
+/**
+ * @brief   : 插值播放时钟实现
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#include "playbackclock.h"
+
+PlaybackClock::PlaybackClock(mpv_handle *mpv)
+    : m_mpv(mpv),
+      m_valid(false),
+      m_running(false),
+      m_anchorSec(0.0),
+      m_anchorUs(0),
+      m_speed(1.0),
+      m_durationSec(0.0)
+{
+}
+
+void PlaybackClock::sync(double posSec, qint64 timeUs)
+{
+    m_anchorSec = posSec;
+    m_anchorUs = timeUs;
+    m_valid = true;
+}
+
+void PlaybackClock::setRunning(bool running, qint64 timeUs)
+{
+    if (running == m_running) return;
+    // 先按旧状态推进到切换时刻，再换状态，避免位置跳变
+    if (m_valid) {
+        m_anchorSec = extrapolate(timeUs);
+        m_anchorUs = timeUs;
+    }
+    m_running = running;
+}
+
+void PlaybackClock::setSpeed(double speed, qint64 timeUs)
+{
+    if (m_valid) {
+        m_anchorSec = extrapolate(timeUs);
+        m_anchorUs = timeUs;
+    }
+    m_speed = speed;
+}
+
+void PlaybackClock::reset()
+{
+    m_valid = false;
+    m_running = false;
+    m_anchorSec = 0.0;
+    m_anchorUs = 0;
+    m_durationSec = 0.0;
+}
+
+double PlaybackClock::positionSec() const
+{
+    if (!m_valid) return -1.0;
+    if (!m_running || !m_mpv) return m_anchorSec;
+    return extrapolate(mpv_get_time_us(m_mpv));
+}
+
+qint64 PlaybackClock::positionMs() const
+{
+    double sec = positionSec();
+    return sec < 0 ? -1 : qint64(sec * 1000);
+}
+
+double PlaybackClock::extrapolate(qint64 nowUs) const
+{
+    double pos = m_anchorSec;
+    if (m_running && nowUs > m_anchorUs) {
+        pos += (nowUs - m_anchorUs) / 1e6 * m_speed;
+    }
+    if (m_durationSec > 0 && pos > m_durationSec) {
+        pos = m_durationSec;
+    }
+    return pos;
+}
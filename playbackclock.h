@@ -0,0 +1,47 @@
+/**
+ * @brief   : 插值播放时钟，记录最近一次权威 time-pos 及其时间戳，供 UI 按帧率读取外推位置
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#ifndef PLAYBACKCLOCK_H
+#define PLAYBACKCLOCK_H
+
+#include <QtGlobal>
+#include <mpv/client.h>
+
+class PlaybackClock
+{
+public:
+    explicit PlaybackClock(mpv_handle *mpv = nullptr);
+
+    void setHandle(mpv_handle *mpv) { m_mpv = mpv; }
+
+    // 以下由 MPVPlayer 在 GUI 线程调用，timeUs 为 mpv_get_time_us 时间戳
+    void sync(double posSec, qint64 timeUs);     // 权威位置（time-pos）
+    void setRunning(bool running, qint64 timeUs); // 播放/暂停/seek 中
+    void setSpeed(double speed, qint64 timeUs);
+    void setDuration(double durationSec) { m_durationSec = durationSec; }
+    void reset();
+
+    bool isValid() const { return m_valid; }
+    bool isRunning() const { return m_running; }
+    double speed() const { return m_speed; }
+    double durationSec() const { return m_durationSec; }
+
+    // 外推当前位置，不访问 mpv 属性；无效时返回 -1
+    double positionSec() const;
+    qint64 positionMs() const;
+
+private:
+    double extrapolate(qint64 nowUs) const;
+
+    mpv_handle *m_mpv;
+    bool m_valid;
+    bool m_running;
+    double m_anchorSec;   // 锚点位置
+    qint64 m_anchorUs;    // 锚点时间
+    double m_speed;
+    double m_durationSec; // <= 0 表示未知，不做上限
+};
+
+#endif // PLAYBACKCLOCK_H
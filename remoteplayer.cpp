@@ -0,0 +1,354 @@
+/**
+ * @brief   : 独立音频进程代理实现
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#include "remoteplayer.h"
+#include <QCoreApplication>
+#include <QLocalSocket>
+#include <QProcess>
+#include <QDataStream>
+#include <QDebug>
+
+// 连接失败后的重试间隔（毫秒）
+static const int kReconnectIntervalMs = 200;
+// 拉起引擎后多久还连不上才再拉一次（毫秒）
+static const int kSpawnGraceMs = 3000;
+// 读共享内存发出 positionChanged 的间隔（毫秒）；歌词等按帧率直接读 positionMs()
+static const int kPollIntervalMs = 50;
+
+RemotePlayer::RemotePlayer(const QString &serverName, QObject *parent)
+    : AudioPlayer(parent),
+      m_serverName(serverName),
+      m_socket(new QLocalSocket(this)),
+      m_shm(engineStatusKey(serverName)),
+      m_shuttingDown(false),
+      m_stopEngineOnExit(false),
+      m_volume(-1),
+      m_speed(1.0),
+      m_crossfadeSec(0.0),
+      m_lowLatency(false),
+      m_metering(false)
+{
+    connect(m_socket, &QLocalSocket::connected, this, &RemotePlayer::onConnected);
+    connect(m_socket, &QLocalSocket::disconnected, this, &RemotePlayer::onDisconnected);
+    connect(m_socket, &QLocalSocket::readyRead, this, &RemotePlayer::onReadyRead);
+    connect(m_socket, static_cast<void (QLocalSocket::*)(QLocalSocket::LocalSocketError)>(&QLocalSocket::error),
+            this, &RemotePlayer::onSocketError);
+
+    m_reconnectTimer.setSingleShot(true);
+    m_reconnectTimer.setInterval(kReconnectIntervalMs);
+    connect(&m_reconnectTimer, &QTimer::timeout, this, &RemotePlayer::connectToEngine);
+
+    m_pollTimer.setInterval(kPollIntervalMs);
+    connect(&m_pollTimer, &QTimer::timeout, this, &RemotePlayer::pollStatus);
+
+    connectToEngine();
+}
+
+RemotePlayer::~RemotePlayer()
+{
+    m_shuttingDown = true;
+    if (m_socket->state() != QLocalSocket::ConnectedState) return;
+    // 默认只断开：引擎没有界面时自己解析地址继续播放，停下来空闲一段时间后自行退出
+    if (m_stopEngineOnExit) send(CmdShutdown);
+    m_socket->waitForBytesWritten(200);
+    m_socket->disconnectFromServer();
+}
+
+/*-------------------------------
+ * 连接管理：先连已有引擎（界面重启后继续控制正在播放的引擎），
+ * 连不上才拉起新进程；引擎以分离方式启动，不随界面退出
+ *------------------------------*/
+void RemotePlayer::connectToEngine()
+{
+    if (m_shuttingDown || m_socket->state() != QLocalSocket::UnconnectedState) return;
+    m_socket->connectToServer(m_serverName);
+}
+
+void RemotePlayer::onSocketError(QLocalSocket::LocalSocketError error)
+{
+    // 对端关闭由 onDisconnected 处理
+    if (m_shuttingDown || error == QLocalSocket::PeerClosedError) return;
+
+    // 连不上：刚拉起的引擎可能还在初始化，宽限期过了仍连不上再拉一次
+    if (!m_spawnTimer.isValid() || m_spawnTimer.elapsed() > kSpawnGraceMs) spawnEngine();
+    m_reconnectTimer.start();
+}
+
+void RemotePlayer::spawnEngine()
+{
+    QProcess::startDetached(QCoreApplication::applicationFilePath(),
+                            QStringList() << "--audio-engine" << m_serverName);
+    m_spawnTimer.restart();
+}
+
+void RemotePlayer::onConnected()
+{
+    m_spawnTimer.invalidate();
+    if (!m_shm.isAttached() && !m_shm.attach(QSharedMemory::ReadOnly)) {
+        qWarning() << "audio engine status unavailable:" << m_shm.errorString();
+    }
+
+    // 设置先于缓存的命令（其中有断点续播的加载），重启的引擎从一开始就按界面的设置播放
+    sendSettings();
+    const QList<QByteArray> pending = m_pending;
+    m_pending.clear();
+    for (const QByteArray &frame : pending) m_socket->write(frame);
+    pollStatus();
+}
+
+void RemotePlayer::onDisconnected()
+{
+    if (m_shuttingDown) return;
+    m_shm.detach();
+
+    // 引擎意外退出：从断点续播，命令先缓存，重连后发出
+    qint64 resumeMs = m_status.positionMs;
+    bool wasPlaying = m_status.playing;
+    m_status = EngineStatus();
+    m_pollTimer.stop();
+    m_spawnTimer.invalidate();
+    m_reconnectTimer.start();
+    if (wasPlaying) emit streamFailed(qMax<qint64>(0, resumeMs), false);
+}
+
+void RemotePlayer::onReadyRead()
+{
+    QDataStream in(m_socket);
+    in.setVersion(kEngineStreamVersion);
+
+    forever {
+        in.startTransaction();
+        quint8 type = 0;
+        QVariantList args;
+        in >> type >> args;
+        if (!in.commitTransaction()) break;
+        handleEvent(type, args);
+    }
+}
+
+void RemotePlayer::handleEvent(int type, const QVariantList &args)
+{
+    auto arg = [&args](int i) { return i < args.size() ? args.at(i) : QVariant(); };
+
+    switch (type) {
+    case EvtPlaybackFinished: emit playbackFinished(); break;
+    case EvtTrackAdvanced:    emit trackAdvanced(); break;
+    case EvtStreamFailed:     emit streamFailed(arg(0).toLongLong(), arg(1).toBool()); break;
+    case EvtSongUrlRequested: emit songUrlRequested(arg(0).toInt()); break;
+    case EvtBufferedRanges: {
+        QVector<BufferedRange> ranges;
+        for (int i = 0; i + 1 < args.size(); i += 2) {
+            BufferedRange r;
+            r.startMs = args.at(i).toLongLong();
+            r.endMs = args.at(i + 1).toLongLong();
+            ranges.append(r);
+        }
+        m_ranges = ranges;
+        emit bufferedRangesChanged(m_ranges);
+        break;
+    }
+    case EvtAudioDevices: {
+        QList<MpvAudioDevice> devices;
+        for (int i = 0; i + 1 < args.size(); i += 2) {
+            MpvAudioDevice d;
+            d.name = args.at(i).toString();
+            d.description = args.at(i + 1).toString();
+            devices.append(d);
+        }
+        m_devices = devices;
+        emit audioDevicesChanged(m_devices);
+        break;
+    }
+    case EvtFirstAudio:       emit firstAudio(arg(0).toLongLong()); break;
+    case EvtSeekCompleted:    emit seekCompleted(arg(0).toLongLong(), arg(1).toBool()); break;
+    case EvtSeekWillStall:    emit seekWillStall(arg(0).toLongLong(), arg(1).toLongLong()); break;
+    case EvtOutputLatency:    emit outputLatencyMeasured(arg(0).toLongLong()); break;
+    case EvtLevels:
+        // 关闭后仍可能收到在途的一帧，丢掉
+        if (m_metering) emit levelsChanged(AudioLevels::fromVariant(args));
+        break;
+    case EvtStatusChanged:    pollStatus(); break;
+    case EvtRequestFailed:
+        emit requestFailed(arg(0).toULongLong(), arg(1).toInt(), arg(2).toString());
+        break;
+    default:
+        qWarning() << "audio engine: unknown event" << type;
+        break;
+    }
+}
+
+void RemotePlayer::send(int type, const QVariantList &args)
+{
+    QByteArray frame;
+    QDataStream out(&frame, QIODevice::WriteOnly);
+    out.setVersion(kEngineStreamVersion);
+    out << quint8(type) << args;
+
+    if (m_socket->state() == QLocalSocket::ConnectedState) m_socket->write(frame);
+    else m_pending.append(frame);
+}
+
+// 设置类命令：没连上时不排队，只记下最新值，连上后由 sendSettings 统一发出
+void RemotePlayer::sendSetting(int type, const QVariantList &args)
+{
+    if (m_socket->state() == QLocalSocket::ConnectedState) send(type, args);
+}
+
+void RemotePlayer::sendSettings()
+{
+    if (m_volume >= 0) send(CmdSetVolume, QVariantList() << m_volume);
+    send(CmdSetSpeed, QVariantList() << m_speed);
+    send(CmdSetCrossfade, QVariantList() << m_crossfadeSec);
+    if (!m_audioDevice.isEmpty()) send(CmdSetAudioDevice, QVariantList() << m_audioDevice);
+    send(CmdSetLowLatency, QVariantList() << m_lowLatency);
+    send(CmdSetDsp, QVariantList() << m_dsp.toVariant());
+    send(CmdSetMetering, QVariantList() << m_metering);
+}
+
+/*-------------------------------
+ * 状态读取：共享内存里的最新快照，不经过套接字
+ *------------------------------*/
+bool RemotePlayer::readStatus(EngineStatus &status) const
+{
+    if (!m_shm.isAttached()) return false;
+    return readEngineStatus(static_cast<const EngineStatusRing *>(m_shm.constData()), status);
+}
+
+qint64 RemotePlayer::positionMs() const
+{
+    EngineStatus status;
+    return readStatus(status) ? status.positionMs : m_status.positionMs;
+}
+
+qint64 RemotePlayer::durationMs() const
+{
+    EngineStatus status;
+    return readStatus(status) ? status.durationMs : m_status.durationMs;
+}
+
+void RemotePlayer::pollStatus()
+{
+    EngineStatus status;
+    if (!readStatus(status)) {
+        m_pollTimer.stop();
+        return;
+    }
+    // 与界面的帧定时器一样只在播放时运行，暂停/空闲时靠 EvtStatusChanged 唤醒
+    if (!status.playing) m_pollTimer.stop();
+    else if (!m_pollTimer.isActive()) m_pollTimer.start();
+
+    EngineStatus old = m_status;
+    m_status = status;
+    if (status.durationMs != old.durationMs) emit durationChanged(status.durationMs);
+    if (status.positionMs != old.positionMs && status.positionMs >= 0) emit positionChanged(status.positionMs);
+    if (status.playing != old.playing) emit stateChanged(status.playing);
+}
+
+/*-------------------------------
+ * 命令：原样转发给引擎
+ *------------------------------*/
+quint64 RemotePlayer::playSong(int songId, qint64 startMs)
+{
+    send(CmdPlaySong, QVariantList() << songId << startMs);
+    return 0;
+}
+
+quint64 RemotePlayer::queueNextSong(int songId)
+{
+    send(CmdQueueNextSong, QVariantList() << songId);
+    return 0;
+}
+
+void RemotePlayer::provideSongUrl(int songId, const QString &url, double gainDb, const TrackTrim &trim)
+{
+    send(CmdProvideSongUrl, QVariantList() << songId << url << gainDb << trim.startMs << trim.endMs);
+}
+
+void RemotePlayer::clearQueue()
+{
+    send(CmdClearQueue);
+}
+
+quint64 RemotePlayer::play()
+{
+    send(CmdPlay);
+    return 0;
+}
+
+quint64 RemotePlayer::pause()
+{
+    send(CmdPause);
+    return 0;
+}
+
+quint64 RemotePlayer::stop()
+{
+    send(CmdStop);
+    return 0;
+}
+
+quint64 RemotePlayer::setVolume(int vol)
+{
+    m_volume = vol;
+    sendSetting(CmdSetVolume, QVariantList() << vol);
+    return 0;
+}
+
+quint64 RemotePlayer::setPosition(qint64 ms)
+{
+    send(CmdSetPosition, QVariantList() << ms);
+    return 0;
+}
+
+void RemotePlayer::setSpeed(double speed)
+{
+    m_speed = speed;
+    sendSetting(CmdSetSpeed, QVariantList() << speed);
+}
+
+void RemotePlayer::setCrossfade(double seconds)
+{
+    m_crossfadeSec = seconds;
+    sendSetting(CmdSetCrossfade, QVariantList() << seconds);
+}
+
+void RemotePlayer::beginScrub()
+{
+    send(CmdBeginScrub);
+}
+
+void RemotePlayer::scrubTo(qint64 ms)
+{
+    send(CmdScrubTo, QVariantList() << ms);
+}
+
+void RemotePlayer::endScrub(qint64 ms)
+{
+    send(CmdEndScrub, QVariantList() << ms);
+}
+
+void RemotePlayer::setAudioDevice(const QString &name)
+{
+    m_audioDevice = name;
+    sendSetting(CmdSetAudioDevice, QVariantList() << name);
+}
+
+void RemotePlayer::setLowLatency(bool enabled)
+{
+    m_lowLatency = enabled;
+    sendSetting(CmdSetLowLatency, QVariantList() << enabled);
+}
+
+void RemotePlayer::setDsp(const DspSettings &dsp)
+{
+    m_dsp = dsp;
+    sendSetting(CmdSetDsp, QVariantList() << dsp.toVariant());
+}
+
+void RemotePlayer::setMetering(bool enabled)
+{
+    m_metering = enabled;
+    sendSetting(CmdSetMetering, QVariantList() << enabled);
+}
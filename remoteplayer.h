@@ -0,0 +1,99 @@
+/**
+ * @brief   : 独立音频进程的界面侧代理：实现 AudioPlayer 接口，命令经本地套接字发给引擎，
+ *            位置/时长/状态直接读共享内存；引擎不在时自动拉起，断开后自动重连
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#ifndef REMOTEPLAYER_H
+#define REMOTEPLAYER_H
+
+#include <QTimer>
+#include <QByteArray>
+#include <QVariantList>
+#include <QSharedMemory>
+#include <QElapsedTimer>
+#include <QLocalSocket>
+#include "audioplayer.h"
+#include "engineprotocol.h"
+
+class RemotePlayer : public AudioPlayer
+{
+    Q_OBJECT
+public:
+    explicit RemotePlayer(const QString &serverName, QObject *parent = nullptr);
+    ~RemotePlayer(); // 断开连接，引擎继续播放；设置了随界面停止时通知引擎退出
+
+    // 界面正常退出时是否一并结束引擎（Engine/stopWithGui），默认不结束，界面重启后接着控制
+    void setStopEngineOnExit(bool enabled) { m_stopEngineOnExit = enabled; }
+
+    quint64 playSong(int songId, qint64 startMs = -1) override;
+    quint64 queueNextSong(int songId) override;
+    void provideSongUrl(int songId, const QString &url, double gainDb = 0.0,
+                        const TrackTrim &trim = TrackTrim()) override;
+    void clearQueue() override;
+    quint64 play() override;
+    quint64 pause() override;
+    quint64 stop() override;
+    quint64 setVolume(int vol) override;
+    quint64 setPosition(qint64 ms) override;
+    void setSpeed(double speed) override;
+    void setCrossfade(double seconds) override;
+    void beginScrub() override;
+    void scrubTo(qint64 ms) override;
+    void endScrub(qint64 ms) override;
+
+    QVector<BufferedRange> bufferedRanges() const override { return m_ranges; }
+    QList<MpvAudioDevice> audioDevices() const override { return m_devices; }
+    QString audioDevice() const override { return m_audioDevice; }
+    void setAudioDevice(const QString &name) override;
+    void setLowLatency(bool enabled) override;
+    bool isLowLatency() const override { return m_lowLatency; }
+    void setDsp(const DspSettings &dsp) override;
+    DspSettings dsp() const override { return m_dsp; }
+    void setMetering(bool enabled) override;
+    bool isMetering() const override { return m_metering; }
+
+    bool isPlaying() const override { return m_status.playing; }
+    qint64 positionMs() const override;
+    qint64 durationMs() const override;
+
+private slots:
+    void connectToEngine();
+    void onConnected();
+    void onDisconnected();
+    void onSocketError(QLocalSocket::LocalSocketError error);
+    void onReadyRead();
+    void pollStatus(); // 读共享内存，变化时发出 position/duration/state 信号；只在播放时定时运行
+
+private:
+    void send(int type, const QVariantList &args = QVariantList());
+    void sendSetting(int type, const QVariantList &args);
+    void sendSettings();
+    void handleEvent(int type, const QVariantList &args);
+    bool readStatus(EngineStatus &status) const;
+    void spawnEngine();
+
+    QString m_serverName;
+    QLocalSocket *m_socket;
+    QSharedMemory m_shm;
+    QTimer m_reconnectTimer;
+    QTimer m_pollTimer;
+    QElapsedTimer m_spawnTimer;      // 距上次拉起引擎的时间，避免重复拉起
+    QList<QByteArray> m_pending;     // 连上之前的命令，连上后按顺序发出
+    bool m_shuttingDown;
+    bool m_stopEngineOnExit;
+
+    EngineStatus m_status;           // 上一次读到的快照
+    QVector<BufferedRange> m_ranges;
+    QList<MpvAudioDevice> m_devices;
+    // 各项设置的最新值：引擎崩溃重启后全部重发，新引擎和界面保持一致
+    int m_volume;                    // -1 表示还没设置过
+    double m_speed;
+    double m_crossfadeSec;
+    QString m_audioDevice;
+    bool m_lowLatency;
+    DspSettings m_dsp;
+    bool m_metering;
+};
+
+#endif // REMOTEPLAYER_H
@@ -0,0 +1,488 @@
+/**
+ * @brief   : 歌曲列表 JSON 快速解析实现
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#include "searchlistparser.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#define JSON_USE_SSE2
+#endif
+
+// 基准：每种解析跑的轮数，取最快的一轮
+static const int kBenchRounds = 5;
+
+/*-------------------------------
+ * 扫描位置；出错时 ok 置 false，之后的操作都直接返回
+ *------------------------------*/
+struct JsonCursor {
+    const char *p;
+    const char *end;
+    bool ok;
+};
+
+static inline void skipSpace(JsonCursor &c)
+{
+    while (c.p < c.end && (*c.p == ' ' || *c.p == '\n' || *c.p == '\r' || *c.p == '\t')) ++c.p;
+}
+
+static inline bool consume(JsonCursor &c, char ch)
+{
+    skipSpace(c);
+    if (c.p < c.end && *c.p == ch) {
+        ++c.p;
+        return true;
+    }
+    return false;
+}
+
+static inline bool fail(JsonCursor &c)
+{
+    c.ok = false;
+    return false;
+}
+
+#ifdef JSON_USE_SSE2
+static inline int matchMask(__m128i block, char ch)
+{
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8(ch)));
+}
+
+// 掩码中最低的置位，即块内第一个命中的字节
+static inline int firstMatch(int mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, unsigned(mask));
+    return int(index);
+#else
+    return __builtin_ctz(unsigned(mask));
+#endif
+}
+#endif
+
+// 字符串内：下一个引号或反斜杠
+static inline const char *findQuoteOrEscape(const char *p, const char *end)
+{
+#ifdef JSON_USE_SSE2
+    for (; p + 16 <= end; p += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        int mask = matchMask(block, '"') | matchMask(block, '\\');
+        if (mask) return p + firstMatch(mask);
+    }
+#endif
+    while (p < end && *p != '"' && *p != '\\') ++p;
+    return p;
+}
+
+// 容器内：下一个引号或括号
+static inline const char *findStructural(const char *p, const char *end)
+{
+#ifdef JSON_USE_SSE2
+    for (; p + 16 <= end; p += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        int mask = matchMask(block, '"') | matchMask(block, '{') | matchMask(block, '}')
+                | matchMask(block, '[') | matchMask(block, ']');
+        if (mask) return p + firstMatch(mask);
+    }
+#endif
+    while (p < end && *p != '"' && *p != '{' && *p != '}' && *p != '[' && *p != ']') ++p;
+    return p;
+}
+
+/*-------------------------------
+ * 字符串：先只找边界，记下是否有转义；
+ * 没有转义（绝大多数）时直接按 UTF-8 转 QString，不经过中间缓冲
+ *------------------------------*/
+struct RawString {
+    const char *begin;
+    const char *end;
+    bool escaped;
+};
+
+static bool readRawString(JsonCursor &c, RawString &s)
+{
+    skipSpace(c);
+    if (c.p >= c.end || *c.p != '"') return fail(c);
+    s.begin = ++c.p;
+    s.escaped = false;
+    for (;;) {
+        const char *q = findQuoteOrEscape(c.p, c.end);
+        if (q >= c.end) return fail(c);
+        if (*q == '"') {
+            s.end = q;
+            c.p = q + 1;
+            return true;
+        }
+        s.escaped = true;
+        c.p = q + 2; // 反斜杠和它转义的字符
+    }
+}
+
+static int hexValue(const char *p)
+{
+    int v = 0;
+    for (int i = 0; i < 4; ++i) {
+        char ch = p[i];
+        v <<= 4;
+        if (ch >= '0' && ch <= '9') v |= ch - '0';
+        else if (ch >= 'a' && ch <= 'f') v |= ch - 'a' + 10;
+        else if (ch >= 'A' && ch <= 'F') v |= ch - 'A' + 10;
+        else return -1;
+    }
+    return v;
+}
+
+static void appendUtf8(QByteArray &out, uint cp)
+{
+    if (cp < 0x80) {
+        out.append(char(cp));
+    } else if (cp < 0x800) {
+        out.append(char(0xC0 | (cp >> 6)));
+        out.append(char(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.append(char(0xE0 | (cp >> 12)));
+        out.append(char(0x80 | ((cp >> 6) & 0x3F)));
+        out.append(char(0x80 | (cp & 0x3F)));
+    } else {
+        out.append(char(0xF0 | (cp >> 18)));
+        out.append(char(0x80 | ((cp >> 12) & 0x3F)));
+        out.append(char(0x80 | ((cp >> 6) & 0x3F)));
+        out.append(char(0x80 | (cp & 0x3F)));
+    }
+}
+
+// 带转义的字符串：两个转义之间的片段整段拷贝
+static bool unescape(const RawString &s, QByteArray &out)
+{
+    out.clear();
+    const char *p = s.begin;
+    while (p < s.end) {
+        const char *q = findQuoteOrEscape(p, s.end);
+        out.append(p, int(q - p));
+        if (q >= s.end) break;
+        if (q + 1 >= s.end) return false;
+        switch (q[1]) {
+        case '"':  out.append('"'); break;
+        case '\\': out.append('\\'); break;
+        case '/':  out.append('/'); break;
+        case 'b':  out.append('\b'); break;
+        case 'f':  out.append('\f'); break;
+        case 'n':  out.append('\n'); break;
+        case 'r':  out.append('\r'); break;
+        case 't':  out.append('\t'); break;
+        case 'u': {
+            if (q + 6 > s.end) return false;
+            int cp = hexValue(q + 2);
+            if (cp < 0) return false;
+            // 代理对：\uD8xx\uDCxx 合成一个码点
+            if (cp >= 0xD800 && cp <= 0xDBFF && q + 12 <= s.end && q[6] == '\\' && q[7] == 'u') {
+                int low = hexValue(q + 8);
+                if (low >= 0xDC00 && low <= 0xDFFF) {
+                    appendUtf8(out, 0x10000 + ((uint(cp) - 0xD800) << 10) + (uint(low) - 0xDC00));
+                    p = q + 12;
+                    continue;
+                }
+            }
+            appendUtf8(out, uint(cp));
+            p = q + 6;
+            continue;
+        }
+        default:
+            return false;
+        }
+        p = q + 2;
+    }
+    return true;
+}
+
+static bool toQString(const RawString &s, QString &value, QByteArray &scratch)
+{
+    if (!s.escaped) {
+        value = QString::fromUtf8(s.begin, int(s.end - s.begin));
+        return true;
+    }
+    if (!unescape(s, scratch)) return false;
+    value = QString::fromUtf8(scratch.constData(), scratch.size());
+    return true;
+}
+
+static inline bool keyEquals(const RawString &key, const char *name, int length)
+{
+    return !key.escaped && key.end - key.begin == length && std::memcmp(key.begin, name, size_t(length)) == 0;
+}
+
+/*-------------------------------
+ * 跳过一个值：字符串找结束引号；对象/数组只看括号和字符串边界数层数；
+ * 其他（数字、true/false/null）读到分隔符为止
+ *------------------------------*/
+static bool skipValue(JsonCursor &c)
+{
+    skipSpace(c);
+    if (c.p >= c.end) return fail(c);
+    RawString s;
+    char ch = *c.p;
+    if (ch == '"') return readRawString(c, s);
+    if (ch == '{' || ch == '[') {
+        int depth = 0;
+        while (c.ok) {
+            c.p = findStructural(c.p, c.end);
+            if (c.p >= c.end) return fail(c);
+            switch (*c.p) {
+            case '"':
+                readRawString(c, s);
+                break;
+            case '{':
+            case '[':
+                ++depth;
+                ++c.p;
+                break;
+            default:
+                ++c.p;
+                if (--depth == 0) return true;
+                break;
+            }
+        }
+        return false;
+    }
+    const char *start = c.p;
+    while (c.p < c.end && *c.p != ',' && *c.p != '}' && *c.p != ']'
+           && *c.p != ' ' && *c.p != '\n' && *c.p != '\r' && *c.p != '\t') {
+        ++c.p;
+    }
+    return c.p > start || fail(c);
+}
+
+/*-------------------------------
+ * 整数字段：纯数字走快速路径；带小数/指数时按 double 解析，
+ * 是整数才取值（同 QJsonValue::toInt）；不是数字则跳过并得 0
+ *------------------------------*/
+static bool readInt(JsonCursor &c, int &value)
+{
+    value = 0;
+    skipSpace(c);
+    if (c.p >= c.end) return fail(c);
+    if (*c.p != '-' && (*c.p < '0' || *c.p > '9')) return skipValue(c);
+
+    const char *start = c.p;
+    bool negative = *c.p == '-';
+    if (negative) ++c.p;
+    qint64 v = 0;
+    const char *digits = c.p;
+    while (c.p < c.end && *c.p >= '0' && *c.p <= '9' && c.p - digits < 18) v = v * 10 + (*c.p++ - '0');
+    if (c.p == digits) return fail(c);
+    bool simple = c.p >= c.end || (*c.p != '.' && *c.p != 'e' && *c.p != 'E' && (*c.p < '0' || *c.p > '9'));
+    if (simple) {
+        if (negative) v = -v;
+        if (v >= INT_MIN && v <= INT_MAX) value = int(v);
+        return true;
+    }
+
+    c.p = start;
+    if (!skipValue(c)) return false;
+    QByteArray token(start, int(c.p - start));
+    char *stop = nullptr;
+    double d = std::strtod(token.constData(), &stop);
+    if (stop != token.constData() + token.size()) return fail(c);
+    if (d >= INT_MIN && d <= INT_MAX && double(int(d)) == d) value = int(d);
+    return true;
+}
+
+static bool readString(JsonCursor &c, QString &value, QByteArray &scratch)
+{
+    value.clear();
+    skipSpace(c);
+    if (c.p >= c.end) return fail(c);
+    if (*c.p != '"') return skipValue(c);
+    RawString s;
+    if (!readRawString(c, s)) return false;
+    return toQString(s, value, scratch) || fail(c);
+}
+
+/*-------------------------------
+ * 逐个读取对象成员：回调处理（或跳过）值，返回 false 时中止
+ *------------------------------*/
+template <typename Handler>
+static bool forEachMember(JsonCursor &c, Handler handle)
+{
+    if (!consume(c, '{')) return fail(c);
+    if (consume(c, '}')) return true;
+    do {
+        RawString key;
+        if (!readRawString(c, key)) return false;
+        if (!consume(c, ':')) return fail(c);
+        if (!handle(key)) return false;
+    } while (consume(c, ','));
+    return consume(c, '}') || fail(c);
+}
+
+static bool parseItem(JsonCursor &c, NetworkManager::SearchItem &item, QByteArray &scratch)
+{
+    return forEachMember(c, [&](const RawString &key) {
+        if (keyEquals(key, "id", 2)) return readInt(c, item.id);
+        if (keyEquals(key, "title", 5)) return readString(c, item.title, scratch);
+        if (keyEquals(key, "singer", 6)) return readString(c, item.singer, scratch);
+        if (keyEquals(key, "picurl", 6)) return readString(c, item.picurl, scratch);
+        if (keyEquals(key, "hit", 3)) return readInt(c, item.hit);
+        return skipValue(c);
+    });
+}
+
+static bool parseList(JsonCursor &c, QList<NetworkManager::SearchItem> &list, QByteArray &scratch)
+{
+    list.clear();
+    if (!consume(c, '[')) return fail(c);
+    if (consume(c, ']')) return true;
+    do {
+        NetworkManager::SearchItem item;
+        item.id = 0;
+        item.hit = 0;
+        skipSpace(c);
+        // 不是对象的元素按空对象处理（QJsonValue::toObject 的行为）
+        bool ok = c.p < c.end && *c.p == '{' ? parseItem(c, item, scratch) : skipValue(c);
+        if (!ok) return false;
+        list.append(item);
+    } while (consume(c, ','));
+    return consume(c, ']') || fail(c);
+}
+
+static bool parseData(JsonCursor &c, QList<NetworkManager::SearchItem> &list, QByteArray &scratch)
+{
+    return forEachMember(c, [&](const RawString &key) {
+        skipSpace(c);
+        if (keyEquals(key, "list", 4) && c.p < c.end && *c.p == '[') return parseList(c, list, scratch);
+        if (keyEquals(key, "list", 4)) list.clear();
+        return skipValue(c);
+    });
+}
+
+bool SearchListParser::parse(const QByteArray &json, QList<NetworkManager::SearchItem> &list)
+{
+    list.clear();
+    JsonCursor c{json.constData(), json.constData() + json.size(), true};
+    QByteArray scratch;
+    int code = 0;
+
+    bool ok = forEachMember(c, [&](const RawString &key) {
+        skipSpace(c);
+        if (keyEquals(key, "code", 4)) return readInt(c, code);
+        if (keyEquals(key, "data", 4) && c.p < c.end && *c.p == '{') return parseData(c, list, scratch);
+        if (keyEquals(key, "data", 4)) list.clear();
+        return skipValue(c);
+    });
+    skipSpace(c);
+    if (!ok || !c.ok || c.p != c.end) {
+        list.clear();
+        return false;
+    }
+    // code 可能出现在 data 之后，最后再判断
+    if (code != 200) list.clear();
+    return true;
+}
+
+bool SearchListParser::parseDom(const QByteArray &json, QList<NetworkManager::SearchItem> &list)
+{
+    list.clear();
+    QJsonParseError err;
+    QJsonDocument doc = QJsonDocument::fromJson(json, &err);
+    if (err.error != QJsonParseError::NoError || !doc.isObject()) return false;
+
+    QJsonObject obj = doc.object();
+    if (obj.value("code").toInt() == 200) {
+        QJsonObject data = obj.value("data").toObject();
+        QJsonArray arr = data.value("list").toArray();
+        for (const QJsonValue &v : arr) {
+            QJsonObject it = v.toObject();
+            NetworkManager::SearchItem si;
+            si.id = it.value("id").toInt();
+            si.title = it.value("title").toString();
+            si.singer = it.value("singer").toString();
+            si.picurl = it.value("picurl").toString();
+            si.hit = it.value("hit").toInt();
+            list.append(si);
+        }
+    }
+    return true;
+}
+
+/*-------------------------------
+ * 基准数据仿照接口的实际输出：PHP json_encode 默认转义斜杠，
+ * 每项还带几个不用的字段（含嵌套），中文、引号转义和 \u 转义都有
+ *------------------------------*/
+static QByteArray makeBenchPayload(int itemCount)
+{
+    QByteArray json;
+    json.reserve(itemCount * 300);
+    json += "{\"code\":200,\"msg\":\"success\",\"data\":{\"total\":";
+    json += QByteArray::number(itemCount);
+    json += ",\"list\":[";
+    for (int i = 0; i < itemCount; ++i) {
+        if (i) json += ',';
+        json += "{\"id\":";
+        json += QByteArray::number(100000 + i * 7);
+        json += ",\"title\":\"";
+        json += (i % 5 == 0) ? "\\u6674\\u5929 \\\"Live\\\" " : "晴天 ";
+        json += QByteArray::number(i);
+        json += "\",\"singer\":\"周杰伦\",\"album\":\"叶惠美\",\"picurl\":\"https:\\/\\/img.example.com\\/cover\\/";
+        json += QByteArray::number(i);
+        json += ".jpg\",\"duration\":\"04:29\",\"hit\":";
+        json += QByteArray::number((i * 7919) % 1000000);
+        json += ",\"tags\":[\"pop\",\"2003\"],\"extra\":{\"vip\":false,\"bitrate\":[128,320],\"note\":null}}";
+    }
+    json += "]}}";
+    return json;
+}
+
+static bool sameItems(const QList<NetworkManager::SearchItem> &a, const QList<NetworkManager::SearchItem> &b)
+{
+    if (a.size() != b.size()) return false;
+    for (int i = 0; i < a.size(); ++i) {
+        const auto &x = a.at(i), &y = b.at(i);
+        if (x.id != y.id || x.hit != y.hit || x.title != y.title || x.singer != y.singer || x.picurl != y.picurl)
+            return false;
+    }
+    return true;
+}
+
+int SearchListParser::benchmark(int itemCount)
+{
+    const QByteArray json = makeBenchPayload(qMax(1, itemCount));
+    const double mb = json.size() / (1024.0 * 1024.0);
+
+    QList<NetworkManager::SearchItem> domList, fastList;
+    qint64 domNs = -1, fastNs = -1;
+    QElapsedTimer timer;
+    for (int round = 0; round < kBenchRounds; ++round) {
+        timer.start();
+        parseDom(json, domList);
+        qint64 ns = timer.nsecsElapsed();
+        if (domNs < 0 || ns < domNs) domNs = ns;
+
+        timer.start();
+        parse(json, fastList);
+        ns = timer.nsecsElapsed();
+        if (fastNs < 0 || ns < fastNs) fastNs = ns;
+    }
+
+    bool same = sameItems(domList, fastList);
+    qInfo().noquote() << QString("json list: %1 items, %2 MB").arg(fastList.size()).arg(mb, 0, 'f', 2);
+    qInfo().noquote() << QString("  QJsonDocument: %1 ms, %2 MB/s")
+                         .arg(domNs / 1e6, 0, 'f', 2).arg(mb / (domNs / 1e9), 0, 'f', 1);
+    qInfo().noquote() << QString("  on-demand:     %1 ms, %2 MB/s (%3x)")
+                         .arg(fastNs / 1e6, 0, 'f', 2).arg(mb / (fastNs / 1e9), 0, 'f', 1)
+                         .arg(double(domNs) / fastNs, 0, 'f', 1);
+    qInfo().noquote() << (same ? "  results match" : "  RESULTS DIFFER");
+    return same ? 0 : 1;
+}
@@ -0,0 +1,33 @@
+/**
+ * @brief   : 歌曲列表接口（search.php / gethot.php / getnew.php）的快速解析：
+ *            按需（on-demand）扫描 JSON，不建 DOM，字段直接写进 SearchItem；
+ *            引号/转义/括号的查找用 SSE2 一次比较 16 字节
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#ifndef SEARCHLISTPARSER_H
+#define SEARCHLISTPARSER_H
+
+#include <QByteArray>
+#include <QList>
+#include "networkmanager.h"
+
+/*
+ * 只解析用到的路径 code、data.list[].{id,title,singer,picurl,hit}，其余的值按括号和字符串边界整体跳过，
+ * 不逐个校验（与 simdjson 的 on-demand 模式相同）。字段的取值规则与 QJsonValue 一致：
+ * 整数字段遇到非整数或其他类型得 0，字符串字段遇到其他类型得空串，code 不是 200 时结果为空。
+ */
+class SearchListParser
+{
+public:
+    // 返回 false 表示 JSON 格式错误，此时 list 为空
+    static bool parse(const QByteArray &json, QList<NetworkManager::SearchItem> &list);
+
+    // 原来的 QJsonDocument 解析，作为基准和结果对照
+    static bool parseDom(const QByteArray &json, QList<NetworkManager::SearchItem> &list);
+
+    // Music --bench-json [条数]：生成该规模的列表，两种解析各跑若干轮，核对结果并输出吞吐量
+    static int benchmark(int itemCount);
+};
+
+#endif // SEARCHLISTPARSER_H
@@ -0,0 +1,168 @@
+/**
+ * @brief   : 进度条实现，叠加绘制波形概览和已缓存区间
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+
+#include "seekslider.h"
+#include <QPainter>
+#include <QMouseEvent>
+#include <QStyle>
+#include <QStyleOptionSlider>
+
+SeekSlider::SeekSlider(QWidget *parent)
+    : QSlider(parent)
+{
+    setOrientation(Qt::Horizontal);
+}
+
+void SeekSlider::setBufferedRanges(const QVector<BufferedRange> &ranges)
+{
+    if (ranges == m_ranges) return;
+    m_ranges = ranges;
+    update();
+}
+
+void SeekSlider::setDurationMs(qint64 ms)
+{
+    if (ms == m_durationMs) return;
+    m_durationMs = ms;
+    update();
+}
+
+void SeekSlider::setWaveform(const Waveform &waveform)
+{
+    m_waveform = waveform;
+    m_wavePlayed = m_waveUnplayed = QPixmap();
+    update();
+}
+
+void SeekSlider::clearWaveform()
+{
+    if (m_waveform.isEmpty()) return;
+    setWaveform(Waveform());
+}
+
+QRect SeekSlider::grooveRect() const
+{
+    QStyleOptionSlider opt;
+    initStyleOption(&opt);
+    return style()->subControlRect(QStyle::CC_Slider, &opt, QStyle::SC_SliderGroove, this);
+}
+
+QRect SeekSlider::handleRect() const
+{
+    QStyleOptionSlider opt;
+    initStyleOption(&opt);
+    return style()->subControlRect(QStyle::CC_Slider, &opt, QStyle::SC_SliderHandle, this);
+}
+
+/*-------------------------------
+ * 样式表里的槽是不透明的，所以先让 QSlider 画完，
+ * 再在上面叠半透明的波形和缓存区间（避开滑块）
+ *------------------------------*/
+void SeekSlider::paintEvent(QPaintEvent *event)
+{
+    QSlider::paintEvent(event);
+    bool hasRanges = !m_ranges.isEmpty() && m_durationMs > 0;
+    if (m_waveform.isEmpty() && !hasRanges) return;
+
+    QRect groove = grooveRect();
+    QRect handle = handleRect();
+
+    QPainter p(this);
+    p.setClipRegion(QRegion(rect()).subtracted(handle));
+
+    if (!m_waveform.isEmpty()) {
+        if (m_wavePlayed.isNull()) rebuildWaveform(groove);
+        // 滑块左侧用已播放的颜色，只截取缓存图，不重新计算
+        int split = qBound(0, handle.center().x() - groove.left(), groove.width());
+        p.drawPixmap(groove.left(), 0, m_wavePlayed, 0, 0, split, height());
+        p.drawPixmap(groove.left() + split, 0, m_waveUnplayed, split, 0, groove.width() - split, height());
+    }
+
+    if (!hasRanges) return;
+    p.setPen(Qt::NoPen);
+    p.setBrush(QColor(255, 255, 255, 70));
+
+    int h = 4;
+    int y = groove.center().y() - h / 2;
+    for (const BufferedRange &r : m_ranges) {
+        int x1 = msToX(r.startMs, groove);
+        int x2 = msToX(r.endMs, groove);
+        if (x2 > x1) p.drawRect(x1, y, x2 - x1, h);
+    }
+}
+
+void SeekSlider::resizeEvent(QResizeEvent *event)
+{
+    QSlider::resizeEvent(event);
+    m_wavePlayed = m_waveUnplayed = QPixmap();
+}
+
+void SeekSlider::rebuildWaveform(const QRect &groove)
+{
+    m_wavePlayed = renderWaveform(groove, QColor(211, 58, 49, 110), QColor(211, 58, 49, 200));
+    m_waveUnplayed = renderWaveform(groove, QColor(150, 150, 150, 90), QColor(150, 150, 150, 170));
+}
+
+/*-------------------------------
+ * 每个像素列合并落在其中的分桶：外层是最小/最大值包络，内层是 RMS，
+ * 副歌等响亮段落一眼就能看出来
+ *------------------------------*/
+QPixmap SeekSlider::renderWaveform(const QRect &groove, const QColor &envelope, const QColor &body) const
+{
+    const int w = qMax(1, groove.width());
+    const int h = height();
+    QPixmap pix(w, h);
+    pix.fill(Qt::transparent);
+
+    const QVector<WaveformBucket> &buckets = m_waveform.buckets;
+    const int count = buckets.size();
+    const double mid = h / 2.0;
+    const double scale = (h / 2.0 - 1) / 127.0;
+
+    QPainter p(&pix);
+    for (int x = 0; x < w; ++x) {
+        int first = int(qint64(x) * count / w);
+        int last = qMax(first + 1, int(qint64(x + 1) * count / w));
+        int minValue = 127, maxValue = -127, rms = 0;
+        for (int i = first; i < last && i < count; ++i) {
+            minValue = qMin<int>(minValue, buckets.at(i).min);
+            maxValue = qMax<int>(maxValue, buckets.at(i).max);
+            rms = qMax<int>(rms, buckets.at(i).rms);
+        }
+        if (maxValue < minValue) continue;
+
+        p.setPen(envelope);
+        p.drawLine(QPointF(x + 0.5, mid - maxValue * scale), QPointF(x + 0.5, mid - minValue * scale));
+        double r = rms / 255.0 * 127.0 * scale;
+        if (r >= 0.5) {
+            p.setPen(body);
+            p.drawLine(QPointF(x + 0.5, mid - r), QPointF(x + 0.5, mid + r));
+        }
+    }
+    return pix;
+}
+
+/*-------------------------------
+ * QSlider 点在槽上只会翻页。这里先把滑块移到点击处，再交给 QSlider，
+ * 等同于按住滑块：松手时照常发出 sliderReleased，按住还可以继续拖
+ *------------------------------*/
+void SeekSlider::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton && maximum() > minimum() && !handleRect().contains(event->pos())) {
+        QRect groove = grooveRect();
+        int handleWidth = handleRect().width();
+        int span = qMax(1, groove.width() - handleWidth);
+        int pos = event->pos().x() - groove.left() - handleWidth / 2;
+        setValue(QStyle::sliderValueFromPosition(minimum(), maximum(), pos, span));
+    }
+    QSlider::mousePressEvent(event);
+}
+
+int SeekSlider::msToX(qint64 ms, const QRect &groove) const
+{
+    qint64 clamped = qBound<qint64>(0, ms, m_durationMs);
+    return groove.left() + int(double(clamped) / m_durationMs * groove.width());
+}
@@ -0,0 +1,51 @@
+/**
+ * @brief   : 进度条，在 QSlider 基础上叠加绘制波形概览和已缓存区间
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+
+#ifndef SEEKSLIDER_H
+#define SEEKSLIDER_H
+
+#include <QSlider>
+#include <QVector>
+#include <QPixmap>
+#include "audioplayer.h"
+#include "waveformgenerator.h"
+
+class SeekSlider : public QSlider
+{
+    Q_OBJECT
+
+public:
+    explicit SeekSlider(QWidget *parent = nullptr);
+
+    // 已缓存区间（毫秒）与总时长（毫秒），slider 的值单位是秒
+    void setBufferedRanges(const QVector<BufferedRange> &ranges);
+    void setDurationMs(qint64 ms);
+
+    // 波形概览：按槽宽画好缓存成两张图（已播放/未播放），尺寸变化时才重画
+    void setWaveform(const Waveform &waveform);
+    void clearWaveform();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override; // 点击槽上任意位置直接跳过去
+
+private:
+    int msToX(qint64 ms, const QRect &groove) const;
+    QRect grooveRect() const;
+    QRect handleRect() const;
+    void rebuildWaveform(const QRect &groove);
+    QPixmap renderWaveform(const QRect &groove, const QColor &envelope, const QColor &body) const;
+
+    QVector<BufferedRange> m_ranges;
+    qint64 m_durationMs = 0;
+
+    Waveform m_waveform;
+    QPixmap m_wavePlayed;
+    QPixmap m_waveUnplayed;
+};
+
+#endif // SEEKSLIDER_H
@@ -0,0 +1,67 @@
+/**
+ * @brief   : 单生产者/单消费者无锁环形队列（mpv 事件线程 -> GUI 线程）
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+/*
+ * 只允许一个线程 push、一个线程 pop。
+ * 容量必须是 2 的幂，实际可用 Capacity - 1 个槽位（留一个区分满/空）。
+ */
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscQueue capacity must be a power of two");
+
+public:
+    SpscQueue() : m_head(0), m_tail(0) {}
+
+    // 生产者线程调用；队列满时返回 false
+    bool push(const T &item)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        const size_t next = (tail + 1) & (Capacity - 1);
+        if (next == m_head.load(std::memory_order_acquire))
+            return false;
+        m_items[tail] = item;
+        m_tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // 消费者线程调用；队列空时返回 false
+    bool pop(T &item)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+            return false;
+        item = m_items[head];
+        m_head.store((head + 1) & (Capacity - 1), std::memory_order_release);
+        return true;
+    }
+
+    // 生产者线程调用：满时先不要取新数据，留在上游
+    bool isFull() const
+    {
+        const size_t next = (m_tail.load(std::memory_order_relaxed) + 1) & (Capacity - 1);
+        return next == m_head.load(std::memory_order_acquire);
+    }
+
+    bool isEmpty() const
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+private:
+    T m_items[Capacity];
+    // 头尾分开放在不同缓存行，避免生产者/消费者互相抖动
+    alignas(64) std::atomic<size_t> m_head;
+    alignas(64) std::atomic<size_t> m_tail;
+};
+
+#endif // SPSCQUEUE_H
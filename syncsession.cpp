@@ -0,0 +1,312 @@
+/**
+ * @brief   : 局域网多机同步播放实现
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#include "syncsession.h"
+#include <QDataStream>
+#include <QNetworkDatagram>
+#include <QSettings>
+#include <QDebug>
+#include <QLoggingCategory>
+
+// 状态变化和定期的偏差报告默认不输出，调试时用 QT_LOGGING_RULES="music.sync.debug=true" 打开
+Q_LOGGING_CATEGORY(lcSync, "music.sync", QtWarningMsg)
+
+static const quint32 kSyncMagic = 0x4D535931; // "MSY1"
+// 从机测量时钟：刚启动时快速测几次，之后每秒一次
+static const int kFastPings = 8;
+static const int kFastPingMs = 100;
+static const int kPingMs = 1000;
+static const int kOffsetSamples = 16;
+// 主机广播状态的间隔；从机超过这么久没有 ping 就不再发给它
+static const int kStateIntervalMs = 200;
+static const qint64 kPeerTimeoutUs = 5000000;
+// 超过这么久收不到主机状态，从机恢复原速
+static const qint64 kLeaderTimeoutUs = 3000000;
+// 纠正策略：误差超过 kResyncMs 直接 seek；否则按比例变速，
+// 误差 kCorrectionMs 对应 100% 的变速（再受 kMaxSpeedDelta 限制），kDeadbandMs 以内保持原速
+static const double kResyncMs = 250.0;
+static const double kCorrectionMs = 2000.0;
+static const double kMaxSpeedDelta = 0.02;
+static const double kDeadbandMs = 3.0;
+static const double kSpeedStep = 0.0005;
+// seek/换曲后等待播放稳定的时间，以及换曲时目标位置的提前量
+static const qint64 kSettleUs = 800000;
+static const qint64 kLoadLeadMs = 300;
+static const qint64 kDefaultSeekLeadMs = 50;
+// 从机每隔多久打印一次同步状态（只在打开 music.sync 调试输出时）
+static const qint64 kReportIntervalUs = 5000000;
+
+SyncSession::Config SyncSession::loadConfig(const QStringList &arguments)
+{
+    Config config;
+    QSettings st("settings.ini", QSettings::IniFormat);
+    QString role = st.value("Sync/role", "off").toString();
+    if (role == "leader") config.role = SyncLeader;
+    else if (role == "follower") config.role = SyncFollower;
+    config.leader = QHostAddress(st.value("Sync/leader", config.leader.toString()).toString());
+    config.port = quint16(st.value("Sync/port", config.port).toUInt());
+
+    for (int i = 1; i + 1 < arguments.size(); ++i) {
+        if (arguments.at(i) == "--sync-leader") {
+            config.role = SyncLeader;
+            config.port = quint16(arguments.at(i + 1).toUInt());
+        } else if (arguments.at(i) == "--sync-follow") {
+            config.role = SyncFollower;
+            const QString target = arguments.at(i + 1);
+            config.leader = QHostAddress(target.section(':', 0, 0));
+            config.port = quint16(target.section(':', 1, 1).toUInt());
+        }
+    }
+    return config;
+}
+
+SyncSession::SyncSession(AudioPlayer *player, const Config &config, QObject *parent)
+    : QObject(parent),
+      m_player(player),
+      m_config(config),
+      m_pingSeq(0),
+      m_samples(kOffsetSamples),
+      m_sampleCount(0),
+      m_offsetUs(0),
+      m_roundTripUs(0),
+      m_settleUntilUs(0),
+      m_seekLeadMs(kDefaultSeekLeadMs),
+      m_lastStateUs(0),
+      m_speed(1.0),
+      m_driftMs(0.0),
+      m_lastReportUs(0)
+{
+    m_clock.start();
+    m_track.id = 0;
+    m_track.hit = 0;
+    connect(&m_socket, &QUdpSocket::readyRead, this, &SyncSession::onReadyRead);
+
+    if (m_config.role == SyncLeader) {
+        if (!m_socket.bind(QHostAddress::AnyIPv4, m_config.port)) {
+            qWarning() << "sync: cannot listen on port" << m_config.port << m_socket.errorString();
+            return;
+        }
+        // 播放状态/位置变化立即广播，平时按固定间隔补发
+        connect(m_player, &AudioPlayer::stateChanged, this, &SyncSession::broadcastState);
+        connect(m_player, &AudioPlayer::seekCompleted, this, &SyncSession::broadcastState);
+        m_stateTimer.setInterval(kStateIntervalMs);
+        connect(&m_stateTimer, &QTimer::timeout, this, &SyncSession::broadcastState);
+        m_stateTimer.start();
+        qCDebug(lcSync) << "sync: leading on port" << m_config.port;
+    } else if (m_config.role == SyncFollower) {
+        if (!m_socket.bind(QHostAddress::AnyIPv4, 0)) {
+            qWarning() << "sync: cannot open socket" << m_socket.errorString();
+            return;
+        }
+        connect(m_player, &AudioPlayer::seekCompleted, this, [this](qint64 latencyMs, bool) {
+            m_seekLeadMs = latencyMs;
+        });
+        connect(&m_pingTimer, &QTimer::timeout, this, &SyncSession::onPingTimeout);
+        m_pingTimer.start(kFastPingMs);
+        qCDebug(lcSync) << "sync: following" << m_config.leader.toString() << m_config.port;
+    }
+}
+
+void SyncSession::setTrack(const NetworkManager::SearchItem &item)
+{
+    m_track = item;
+    if (m_config.role == SyncLeader) broadcastState();
+}
+
+void SyncSession::onReadyRead()
+{
+    while (m_socket.hasPendingDatagrams()) {
+        QNetworkDatagram datagram = m_socket.receiveDatagram();
+        qint64 receivedUs = nowUs();
+        QByteArray data = datagram.data();
+        QDataStream in(&data, QIODevice::ReadOnly);
+        in.setVersion(QDataStream::Qt_5_6);
+        quint32 magic = 0;
+        quint8 type = 0;
+        in >> magic >> type;
+        if (in.status() != QDataStream::Ok || magic != kSyncMagic) continue;
+
+        if (type == MsgPing && m_config.role == SyncLeader) {
+            handlePing(in, datagram.senderAddress(), quint16(datagram.senderPort()), receivedUs);
+        } else if (type == MsgPong && m_config.role == SyncFollower) {
+            handlePong(in, receivedUs);
+        } else if (type == MsgState && m_config.role == SyncFollower) {
+            handleState(in);
+        }
+    }
+}
+
+/*===============================
+ * 主机
+ *==============================*/
+void SyncSession::handlePing(QDataStream &in, const QHostAddress &from, quint16 port, qint64 receivedUs)
+{
+    quint32 seq = 0;
+    qint64 t1 = 0;
+    in >> seq >> t1;
+    if (in.status() != QDataStream::Ok) return;
+
+    QString key = QString("%1:%2").arg(from.toString()).arg(port);
+    if (!m_peers.contains(key)) qCDebug(lcSync) << "sync: follower joined" << key;
+    m_peers.insert(key, Peer{from, port, receivedUs});
+
+    QByteArray reply;
+    QDataStream out(&reply, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_6);
+    out << kSyncMagic << quint8(MsgPong) << seq << t1 << receivedUs << nowUs();
+    m_socket.writeDatagram(reply, from, port);
+}
+
+void SyncSession::broadcastState()
+{
+    qint64 now = nowUs();
+    for (auto it = m_peers.begin(); it != m_peers.end(); ) {
+        if (now - it->lastSeenUs > kPeerTimeoutUs) {
+            qCDebug(lcSync) << "sync: follower left" << it.key();
+            it = m_peers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (m_peers.isEmpty()) return;
+
+    QByteArray datagram;
+    QDataStream out(&datagram, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_6);
+    out << kSyncMagic << quint8(MsgState) << nowUs() << qint32(m_track.id) << m_player->isPlaying()
+        << m_player->positionMs() << m_track.title << m_track.singer << m_track.picurl;
+    for (const Peer &peer : m_peers) m_socket.writeDatagram(datagram, peer.address, peer.port);
+}
+
+/*===============================
+ * 从机
+ *==============================*/
+void SyncSession::onPingTimeout()
+{
+    if (m_pingSeq == quint32(kFastPings)) m_pingTimer.setInterval(kPingMs);
+
+    QByteArray datagram;
+    QDataStream out(&datagram, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_6);
+    out << kSyncMagic << quint8(MsgPing) << m_pingSeq++ << nowUs();
+    m_socket.writeDatagram(datagram, m_config.leader, m_config.port);
+
+    // 主机不在了：不再变速，保持当前播放
+    if (m_lastStateUs && nowUs() - m_lastStateUs > kLeaderTimeoutUs) {
+        m_lastStateUs = 0;
+        applySpeed(1.0);
+        qCDebug(lcSync) << "sync: leader lost";
+    }
+}
+
+void SyncSession::handlePong(QDataStream &in, qint64 receivedUs)
+{
+    quint32 seq = 0;
+    qint64 t1 = 0, t2 = 0, t3 = 0;
+    in >> seq >> t1 >> t2 >> t3;
+    if (in.status() != QDataStream::Ok) return;
+
+    Sample sample;
+    sample.offsetUs = ((t2 - t1) + (t3 - receivedUs)) / 2;
+    sample.roundTripUs = (receivedUs - t1) - (t3 - t2);
+    m_samples[m_sampleCount % kOffsetSamples] = sample;
+    ++m_sampleCount;
+
+    int count = qMin(m_sampleCount, kOffsetSamples);
+    const Sample *best = &m_samples.at(0);
+    for (int i = 1; i < count; ++i) {
+        if (m_samples.at(i).roundTripUs < best->roundTripUs) best = &m_samples.at(i);
+    }
+    m_offsetUs = best->offsetUs;
+    m_roundTripUs = best->roundTripUs;
+}
+
+void SyncSession::handleState(QDataStream &in)
+{
+    qint64 leaderUs = 0, positionMs = 0;
+    qint32 songId = 0;
+    bool playing = false;
+    NetworkManager::SearchItem item;
+    in >> leaderUs >> songId >> playing >> positionMs >> item.title >> item.singer >> item.picurl;
+    if (in.status() != QDataStream::Ok || m_sampleCount == 0) return;
+    item.id = songId;
+    item.hit = 0;
+
+    qint64 now = nowUs();
+    m_lastStateUs = now;
+    // 主机发出之后经过的时间按主机时钟算：本机现在换算到主机时间，减去发出时刻
+    qint64 expectedMs = positionMs;
+    if (playing) expectedMs += (now + m_offsetUs - leaderUs) / 1000;
+
+    // 本机换了别的歌（比如在从机上点了歌）也会在这里被拉回主机的曲目
+    if (songId != m_track.id) {
+        m_settleUntilUs = now + kSettleUs;
+        applySpeed(1.0);
+        if (songId == 0) {
+            m_track = item;
+            m_player->stop();
+        } else {
+            emit trackRequested(item, qMax<qint64>(0, playing ? expectedMs + kLoadLeadMs : expectedMs));
+        }
+        return;
+    }
+    if (songId == 0) return;
+    follow(songId, playing, expectedMs);
+}
+
+/*-------------------------------
+ * 按主机位置纠正本机：大偏差直接 seek（目标加上 seek 耗时），
+ * 小偏差按比例变速，逐渐收敛而不打断声音
+ *------------------------------*/
+void SyncSession::follow(int songId, bool playing, qint64 expectedMs)
+{
+    qint64 now = nowUs();
+    bool settling = now < m_settleUntilUs;
+    qint64 localMs = m_player->positionMs();
+
+    if (!playing) {
+        applySpeed(1.0);
+        if (m_player->isPlaying()) m_player->pause();
+        if (!settling && localMs >= 0 && qAbs(localMs - expectedMs) > kResyncMs) {
+            m_player->setPosition(expectedMs);
+            m_settleUntilUs = now + kSettleUs;
+        }
+        return;
+    }
+    if (settling || localMs < 0) return;
+    if (!m_player->isPlaying()) {
+        m_player->play();
+        m_settleUntilUs = now + kSettleUs;
+        return;
+    }
+
+    m_driftMs = double(localMs - expectedMs);
+    if (qAbs(m_driftMs) > kResyncMs) {
+        applySpeed(1.0);
+        m_player->setPosition(expectedMs + m_seekLeadMs);
+        m_settleUntilUs = now + kSettleUs;
+        qCDebug(lcSync) << "sync: resync" << songId << "drift" << m_driftMs << "ms";
+        return;
+    }
+
+    double speed = 1.0;
+    if (qAbs(m_driftMs) >= kDeadbandMs) {
+        speed = 1.0 - qBound(-kMaxSpeedDelta, m_driftMs / kCorrectionMs, kMaxSpeedDelta);
+    }
+    applySpeed(speed);
+
+    if (lcSync().isDebugEnabled() && now - m_lastReportUs >= kReportIntervalUs) {
+        m_lastReportUs = now;
+        qCDebug(lcSync) << "sync: offset" << offsetMs() << "ms, rtt" << roundTripMs() << "ms, drift" << m_driftMs
+                 << "ms, speed" << m_speed;
+    }
+}
+
+void SyncSession::applySpeed(double speed)
+{
+    if (qAbs(speed - m_speed) < kSpeedStep && !(speed == 1.0 && m_speed != 1.0)) return;
+    m_speed = speed;
+    m_player->setSpeed(speed);
+}
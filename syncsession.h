@@ -0,0 +1,118 @@
+/**
+ * @brief   : 局域网多机同步播放：主机广播当前曲目和位置，从机按 UDP 测得的时钟偏差
+ *            换算主机位置，用 time-pos（大偏差时 seek）和 speed（小偏差时微调）跟住主机
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#ifndef SYNCSESSION_H
+#define SYNCSESSION_H
+
+#include <QObject>
+#include <QUdpSocket>
+#include <QHostAddress>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QHash>
+#include <QVector>
+#include "audioplayer.h"
+#include "networkmanager.h"
+
+/*
+ * 时钟同步仿照 NTP：从机发 ping(t1)，主机回 pong(t1, t2, t3)，从机收到时为 t4，
+ * 偏差 = ((t2 - t1) + (t3 - t4)) / 2，往返 = (t4 - t1) - (t3 - t2)。
+ * 保留最近若干次测量，取往返最短的一次，事件循环的排队延迟不会混进偏差里。
+ * 同一台机器上可以开多个进程，从机用临时端口，经回环地址连到主机端口即可测试。
+ */
+class SyncSession : public QObject
+{
+    Q_OBJECT
+public:
+    enum Role {
+        SyncOff,
+        SyncLeader,
+        SyncFollower
+    };
+
+    struct Config {
+        Role role = SyncOff;
+        QHostAddress leader = QHostAddress(QHostAddress::LocalHost); // 从机要连接的主机
+        quint16 port = 45454;                                        // 主机监听的端口
+    };
+
+    // settings.ini 的 [Sync] 节；命令行 --sync-leader <端口> / --sync-follow <主机>:<端口> 优先
+    static Config loadConfig(const QStringList &arguments);
+
+    SyncSession(AudioPlayer *player, const Config &config, QObject *parent = nullptr);
+
+    Role role() const { return m_config.role; }
+    bool isFollower() const { return m_config.role == SyncFollower; }
+
+    // 本机当前曲目变化时调用。主机立即广播；从机记下来，和主机不同时重新跟随
+    void setTrack(const NetworkManager::SearchItem &item);
+
+    // 从机：最近一次的时钟偏差、往返时间和播放位置误差（毫秒）
+    double offsetMs() const { return m_offsetUs / 1000.0; }
+    double roundTripMs() const { return m_roundTripUs / 1000.0; }
+    double driftMs() const { return m_driftMs; }
+
+signals:
+    // 从机：主机换了曲目，startMs 为应开始的位置
+    void trackRequested(const NetworkManager::SearchItem &item, qint64 startMs);
+
+private slots:
+    void onReadyRead();
+    void onPingTimeout();
+    void broadcastState();
+
+private:
+    enum MessageType {
+        MsgPing = 1, // seq, t1
+        MsgPong,     // seq, t1, t2, t3
+        MsgState     // 主机时间, songId, playing, positionMs, title, singer, picurl
+    };
+
+    struct Peer {
+        QHostAddress address;
+        quint16 port;
+        qint64 lastSeenUs;
+    };
+
+    struct Sample {
+        qint64 offsetUs;
+        qint64 roundTripUs;
+    };
+
+    qint64 nowUs() const { return m_clock.nsecsElapsed() / 1000; }
+    void handlePing(QDataStream &in, const QHostAddress &from, quint16 port, qint64 receivedUs);
+    void handlePong(QDataStream &in, qint64 receivedUs);
+    void handleState(QDataStream &in);
+    void follow(int songId, bool playing, qint64 expectedMs);
+    void applySpeed(double speed);
+
+    AudioPlayer *m_player;
+    Config m_config;
+    QUdpSocket m_socket;
+    QElapsedTimer m_clock;        // 本机单调时钟，双方各用各的，靠偏差换算
+
+    NetworkManager::SearchItem m_track; // 本机当前曲目，id 为 0 表示没有
+
+    // 主机
+    QHash<QString, Peer> m_peers; // "地址:端口" -> 从机，收到 ping 时登记，超时移除
+    QTimer m_stateTimer;
+
+    // 从机
+    QTimer m_pingTimer;
+    quint32 m_pingSeq;
+    QVector<Sample> m_samples;    // 最近的测量，环形覆盖
+    int m_sampleCount;
+    qint64 m_offsetUs;            // 主机时间 - 本机时间
+    qint64 m_roundTripUs;
+    qint64 m_settleUntilUs;       // seek/换曲后等播放稳定再纠正
+    qint64 m_seekLeadMs;          // seek 本身的耗时，目标提前这么多
+    qint64 m_lastStateUs;
+    double m_speed;
+    double m_driftMs;
+    qint64 m_lastReportUs;
+};
+
+#endif // SYNCSESSION_H
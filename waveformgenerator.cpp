@@ -0,0 +1,123 @@
+/**
+ * @brief   : 波形概览调度与缓存实现
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#include "waveformgenerator.h"
+#include "waveformworker.h"
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QSettings>
+#include <QDataStream>
+
+// 缓存目录与文件格式：魔数、分桶数、时长、裁剪起止点，之后是每桶 3 字节。
+// 格式变化时换魔数，旧文件读不出来就会重新生成
+static const char kCacheDir[] = "waveforms";
+static const quint32 kCacheMagic = 0x4D574632; // "MWF2"
+static const quint32 kMaxBuckets = 65536;
+
+Q_STATIC_ASSERT(sizeof(WaveformBucket) == 3);
+
+static QString cacheFile(int songId)
+{
+    return QString("%1/%2.wfm").arg(kCacheDir).arg(songId);
+}
+
+// 读文件头，成功时流停在分桶数据开头
+static bool readHeader(QDataStream &in, quint32 &count, Waveform &waveform)
+{
+    in.setVersion(QDataStream::Qt_5_6);
+    quint32 magic = 0;
+    in >> magic >> count >> waveform.durationMs >> waveform.trim.startMs >> waveform.trim.endMs;
+    return in.status() == QDataStream::Ok && magic == kCacheMagic && count > 0 && count <= kMaxBuckets;
+}
+
+WaveformGenerator::WaveformGenerator(AudioChunkCache *cache, QObject *parent)
+    : AnalysisQueue(cache, parent)
+{
+    QDir().mkpath(kCacheDir);
+    startWorkers(1);
+}
+
+AnalysisWorker *WaveformGenerator::createWorker()
+{
+    return new WaveformWorker(this, m_cache);
+}
+
+void WaveformGenerator::request(int songId)
+{
+    Waveform waveform;
+    if (load(songId, waveform)) {
+        emit waveformReady(songId, waveform);
+        return;
+    }
+    enqueue(songId, true);
+}
+
+bool WaveformGenerator::jobFinished(int songId, const QVariant &result)
+{
+    Q_UNUSED(result);
+    Waveform waveform;
+    if (!load(songId, waveform)) return false;
+    emit waveformReady(songId, waveform);
+    return true;
+}
+
+bool WaveformGenerator::load(int songId, Waveform &waveform)
+{
+    QFile file(cacheFile(songId));
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    quint32 count = 0;
+    Waveform result;
+    if (!readHeader(in, count, result)) return false;
+
+    result.buckets.resize(int(count));
+    int bytes = int(count * sizeof(WaveformBucket));
+    if (in.readRawData(reinterpret_cast<char *>(result.buckets.data()), bytes) != bytes) return false;
+
+    waveform = result;
+    return true;
+}
+
+bool WaveformGenerator::isCached(int songId)
+{
+    QFile file(cacheFile(songId));
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    QDataStream in(&file);
+    quint32 count = 0;
+    Waveform header;
+    return readHeader(in, count, header);
+}
+
+// 只读文件头，每次地址解析完成时调用
+TrackTrim WaveformGenerator::trim(int songId)
+{
+    QSettings st("settings.ini", QSettings::IniFormat);
+    if (!st.value("Playback/trimSilence", true).toBool()) return TrackTrim();
+
+    QFile file(cacheFile(songId));
+    if (!file.open(QIODevice::ReadOnly)) return TrackTrim();
+    QDataStream in(&file);
+    quint32 count = 0;
+    Waveform header;
+    if (!readHeader(in, count, header)) return TrackTrim();
+    return header.trim;
+}
+
+bool WaveformGenerator::save(int songId, const Waveform &waveform)
+{
+    // 先写临时文件再替换，读取方不会看到写了一半的缓存
+    QSaveFile file(cacheFile(songId));
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_6);
+    out << kCacheMagic << quint32(waveform.buckets.size()) << waveform.durationMs
+        << waveform.trim.startMs << waveform.trim.endMs;
+    out.writeRawData(reinterpret_cast<const char *>(waveform.buckets.constData()),
+                     int(waveform.buckets.size() * sizeof(WaveformBucket)));
+    return file.commit();
+}
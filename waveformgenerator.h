@@ -0,0 +1,56 @@
+/**
+ * @brief   : 波形概览：后台线程用无头 mpv 解码出 PCM，归约成几千个分桶（最小/最大/RMS），
+ *            同一遍找出首尾静音的裁剪点，按歌曲 id 存成紧凑的二进制缓存，进度条直接绘制
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#ifndef WAVEFORMGENERATOR_H
+#define WAVEFORMGENERATOR_H
+
+#include <QVector>
+#include <QString>
+#include "analysisqueue.h"
+#include "audioplayer.h"
+
+// 一个分桶：采样值按 [-1, 1] 量化到 int8，RMS 按 [0, 1] 量化到 uint8
+struct WaveformBucket {
+    qint8 min;
+    qint8 max;
+    quint8 rms;
+};
+
+struct Waveform {
+    qint64 durationMs = 0;
+    TrackTrim trim;
+    QVector<WaveformBucket> buckets;
+    bool isEmpty() const { return buckets.isEmpty(); }
+};
+
+// 只有一个解码线程，后请求的排在前面（当前曲目比之前的更要紧）
+class WaveformGenerator : public AnalysisQueue
+{
+    Q_OBJECT
+public:
+    explicit WaveformGenerator(AudioChunkCache *cache, QObject *parent = nullptr);
+
+    // 有缓存时立即发出 waveformReady，否则排到最前生成；
+    // 提前分析（如预排的下一首，要赶在加载前拿到裁剪点）用 enqueue，排在已请求的后面
+    void request(int songId);
+
+    // 二进制缓存读写（waveforms/<歌曲 id>.wfm）
+    static bool load(int songId, Waveform &waveform);
+    static bool save(int songId, const Waveform &waveform);
+    static bool isCached(int songId);
+    // 首尾静音裁剪点；未分析或在 settings.ini 中关闭（Playback/trimSilence）时为空
+    static TrackTrim trim(int songId);
+
+signals:
+    void waveformReady(int songId, const Waveform &waveform);
+
+protected:
+    AnalysisWorker *createWorker() override;
+    bool isDone(int songId) const override { return isCached(songId); }
+    bool jobFinished(int songId, const QVariant &result) override;
+};
+
+#endif // WAVEFORMGENERATOR_H
@@ -0,0 +1,279 @@
+/**
+ * @brief   : 波形解码线程实现
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#include "waveformworker.h"
+#include "waveformgenerator.h"
+#include "audiochunkcache.h"
+#include "mpvplayer.h"
+#include <QTemporaryFile>
+#include <QDir>
+#include <QtMath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define WAVEFORM_USE_SSE
+#endif
+
+// 解码输出：单声道浮点，采样率降到够看清包络即可
+static const int kSampleRate = 22050;
+// 分桶数：比常见进度条宽度多几倍，缩放时仍有细节
+static const int kBucketCount = 2048;
+// 每次从 PCM 文件读取的采样数
+static const int kReadSamples = 65536;
+// 等待事件的超时（秒），期间检查暂停和退出
+static const double kPollSec = 0.2;
+// 静音判定：低于 -60 dBFS 的采样视为静音；短于 kMinSilenceMs 的首尾静音不裁，
+// 裁剪时两端各留一点余量，不切掉起音和混响尾巴
+static const float kSilenceThreshold = 0.001f;
+static const qint64 kMinSilenceMs = 500;
+static const qint64 kLeadInMs = 100;
+static const qint64 kTailOutMs = 300;
+
+WaveformWorker::WaveformWorker(WaveformGenerator *generator, AudioChunkCache *cache)
+    : AnalysisWorker(generator, cache)
+{
+}
+
+// 结果写进缓存文件，界面线程从文件读回
+bool WaveformWorker::process(int songId, const QString &url, QVariant &result)
+{
+    Q_UNUSED(result);
+    Waveform waveform;
+    return generate(url, waveform) && WaveformGenerator::save(songId, waveform);
+}
+
+bool WaveformWorker::generate(const QString &url, Waveform &waveform)
+{
+    QTemporaryFile pcm(QDir::temp().filePath("music-waveform-XXXXXX.pcm"));
+    if (!pcm.open()) return false;
+    // 由 mpv 按路径写入，这里先关掉自己的句柄
+    pcm.close();
+
+    auto cancelled = [this]() { return isQuitting(); };
+    auto paused = [this]() { return isPaused(); };
+    if (!decodePcm(url, pcm.fileName(), kSampleRate, m_cache, QByteArray(), cancelled, paused)) return false;
+    if (!pcm.open()) return false;
+    return reduce(pcm, waveform);
+}
+
+/*-------------------------------
+ * 每首歌一个新内核：ao=pcm 的文件在音频输出关闭时才写完，
+ * 销毁内核是最直接的关闭方式。ao=pcm 本身不按时钟输出，解码多快就写多快。
+ *------------------------------*/
+bool WaveformWorker::decodePcm(const QString &url, const QString &pcmPath, int sampleRate, AudioChunkCache *cache,
+                               const QByteArray &loadOptions, const std::function<bool()> &cancelled,
+                               const std::function<bool()> &paused)
+{
+    mpv_handle *mpv = mpv_create();
+    if (!mpv) return false;
+
+    MPVPlayer::applyAudioOnlyProfile(mpv);
+    QByteArray path = QDir::toNativeSeparators(pcmPath).toUtf8();
+    QByteArray rate = QByteArray::number(sampleRate);
+    mpv_set_option_string(mpv, "ao", "pcm");
+    mpv_set_option_string(mpv, "ao-pcm-file", path.constData());
+    mpv_set_option_string(mpv, "ao-pcm-waveheader", "no");
+    mpv_set_option_string(mpv, "audio-channels", "mono");
+    mpv_set_option_string(mpv, "audio-format", "float");
+    mpv_set_option_string(mpv, "audio-samplerate", rate.constData());
+
+    if (mpv_initialize(mpv) < 0) {
+        mpv_terminate_destroy(mpv);
+        return false;
+    }
+    if (cache) cache->registerWith(mpv);
+
+    QByteArray target = url.toUtf8();
+    // loadfile <url> <flags> <index> <options>
+    const char *load[] = {"loadfile", target.constData(), "replace", "-1", loadOptions.constData(), nullptr};
+    bool ok = false;
+    if (mpv_command(mpv, load) >= 0) {
+        bool done = false;
+        bool isPaused = false;
+        while (!done && !cancelled()) {
+            // 让出：暂停解码，也就不再从网络读取
+            bool wantPause = paused && paused();
+            if (wantPause != isPaused) {
+                isPaused = wantPause;
+                mpv_set_property_string(mpv, "pause", isPaused ? "yes" : "no");
+            }
+
+            mpv_event *event = mpv_wait_event(mpv, kPollSec);
+            switch (event->event_id) {
+            case MPV_EVENT_END_FILE: {
+                const mpv_event_end_file *end = (const mpv_event_end_file *)event->data;
+                ok = end->reason == MPV_END_FILE_REASON_EOF;
+                done = true;
+                break;
+            }
+            case MPV_EVENT_SHUTDOWN:
+                done = true;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    mpv_terminate_destroy(mpv);
+    return ok;
+}
+
+/*-------------------------------
+ * 归约内核：一段采样的最小值、最大值和平方和。
+ * SSE 每次处理 4 个采样，尾部和不支持的平台走标量循环；
+ * 平方和在一个分桶内（几千个采样）用单精度累加足够。
+ *------------------------------*/
+static void reduceSamples(const float *samples, int count, float &minValue, float &maxValue, double &sumSquares)
+{
+    int i = 0;
+#ifdef WAVEFORM_USE_SSE
+    if (count >= 4) {
+        __m128 vmin = _mm_set1_ps(minValue);
+        __m128 vmax = _mm_set1_ps(maxValue);
+        __m128 vsum = _mm_setzero_ps();
+        for (; i + 4 <= count; i += 4) {
+            __m128 v = _mm_loadu_ps(samples + i);
+            vmin = _mm_min_ps(vmin, v);
+            vmax = _mm_max_ps(vmax, v);
+            vsum = _mm_add_ps(vsum, _mm_mul_ps(v, v));
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, vmin);
+        minValue = qMin(qMin(lanes[0], lanes[1]), qMin(lanes[2], lanes[3]));
+        _mm_storeu_ps(lanes, vmax);
+        maxValue = qMax(qMax(lanes[0], lanes[1]), qMax(lanes[2], lanes[3]));
+        _mm_storeu_ps(lanes, vsum);
+        sumSquares += double(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+    }
+#endif
+    for (; i < count; ++i) {
+        float v = samples[i];
+        minValue = qMin(minValue, v);
+        maxValue = qMax(maxValue, v);
+        sumSquares += double(v) * v;
+    }
+}
+
+/*-------------------------------
+ * 静音门限内核：找第一个 / 最后一个绝对值超过门限的采样，找不到返回 -1。
+ * max(v, -v) 取绝对值，一次比较 4 个，movemask 取出命中的通道
+ *------------------------------*/
+static int firstAudible(const float *samples, int count, float threshold)
+{
+    int i = 0;
+#ifdef WAVEFORM_USE_SSE
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 vthr = _mm_set1_ps(threshold);
+    for (; i + 4 <= count; i += 4) {
+        __m128 v = _mm_loadu_ps(samples + i);
+        v = _mm_max_ps(v, _mm_sub_ps(zero, v));
+        int mask = _mm_movemask_ps(_mm_cmpgt_ps(v, vthr));
+        if (mask) {
+            for (int lane = 0; lane < 4; ++lane)
+                if (mask & (1 << lane)) return i + lane;
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        if (qAbs(samples[i]) > threshold) return i;
+    }
+    return -1;
+}
+
+static int lastAudible(const float *samples, int count, float threshold)
+{
+    int i = count;
+#ifdef WAVEFORM_USE_SSE
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 vthr = _mm_set1_ps(threshold);
+    for (; i - 4 >= 0; i -= 4) {
+        __m128 v = _mm_loadu_ps(samples + i - 4);
+        v = _mm_max_ps(v, _mm_sub_ps(zero, v));
+        int mask = _mm_movemask_ps(_mm_cmpgt_ps(v, vthr));
+        if (mask) {
+            for (int lane = 3; lane >= 0; --lane)
+                if (mask & (1 << lane)) return i - 4 + lane;
+        }
+    }
+#endif
+    while (--i >= 0) {
+        if (qAbs(samples[i]) > threshold) return i;
+    }
+    return -1;
+}
+
+static qint8 quantizeSample(float v)
+{
+    return qint8(qBound(-127, qRound(v * 127.0f), 127));
+}
+
+/*-------------------------------
+ * 边读边归约：分桶边界按总采样数均分，一块读入的数据可能跨多个分桶
+ *------------------------------*/
+bool WaveformWorker::reduce(QIODevice &pcm, Waveform &waveform)
+{
+    const qint64 total = pcm.size() / qint64(sizeof(float));
+    if (total <= 0) return false;
+
+    const int buckets = int(qMin<qint64>(kBucketCount, total));
+    waveform.durationMs = total * 1000 / kSampleRate;
+    waveform.buckets.resize(buckets);
+
+    QVector<float> buffer(kReadSamples);
+    qint64 pos = 0;
+    qint64 bucketStart = 0;
+    qint64 bucketEnd = total / buckets;
+    int bucket = 0;
+    float minValue = 1.0f, maxValue = -1.0f;
+    double sumSquares = 0.0;
+    qint64 firstSample = -1, lastSample = -1;
+
+    while (bucket < buckets) {
+        qint64 bytes = pcm.read(reinterpret_cast<char *>(buffer.data()), kReadSamples * qint64(sizeof(float)));
+        int got = int(bytes / qint64(sizeof(float)));
+        if (got <= 0) break;
+
+        // 开头找到出声点后不再正向扫描；结尾从每块末尾倒着找，有声的块第一次比较就命中
+        if (firstSample < 0) {
+            int first = firstAudible(buffer.constData(), got, kSilenceThreshold);
+            if (first >= 0) firstSample = pos + first;
+        }
+        int last = lastAudible(buffer.constData(), got, kSilenceThreshold);
+        if (last >= 0) lastSample = pos + last;
+
+        int offset = 0;
+        while (offset < got && bucket < buckets) {
+            int take = int(qMin<qint64>(got - offset, bucketEnd - pos));
+            reduceSamples(buffer.constData() + offset, take, minValue, maxValue, sumSquares);
+            offset += take;
+            pos += take;
+            if (pos < bucketEnd) continue;
+
+            WaveformBucket &b = waveform.buckets[bucket];
+            b.min = quantizeSample(minValue);
+            b.max = quantizeSample(maxValue);
+            double rms = qSqrt(sumSquares / qMax<qint64>(1, bucketEnd - bucketStart));
+            b.rms = quint8(qBound(0, qRound(rms * 255.0), 255));
+
+            ++bucket;
+            bucketStart = bucketEnd;
+            bucketEnd = total * (bucket + 1) / buckets;
+            minValue = 1.0f;
+            maxValue = -1.0f;
+            sumSquares = 0.0;
+        }
+    }
+    if (bucket != buckets) return false;
+
+    // 全曲静音时不裁剪，交给播放器照常播完
+    if (firstSample >= 0) {
+        qint64 leadMs = firstSample * 1000 / kSampleRate;
+        qint64 lastMs = (lastSample + 1) * 1000 / kSampleRate;
+        if (leadMs >= kMinSilenceMs) waveform.trim.startMs = leadMs - kLeadInMs;
+        if (waveform.durationMs - lastMs >= kMinSilenceMs) waveform.trim.endMs = lastMs + kTailOutMs;
+    }
+    return true;
+}
@@ -0,0 +1,39 @@
+/**
+ * @brief   : 波形解码线程：每首歌一个无头 mpv 内核，ao=pcm 不按时钟写出单声道浮点 PCM，
+ *            再用 SIMD 内核归约成分桶
+ * @author  : 樊晓亮
+ * @date    : 2025.12.12
+ **/
+#ifndef WAVEFORMWORKER_H
+#define WAVEFORMWORKER_H
+
+#include <QIODevice>
+#include <functional>
+#include <mpv/client.h>
+#include "analysisworker.h"
+
+class WaveformGenerator;
+struct Waveform;
+
+class WaveformWorker : public AnalysisWorker
+{
+    Q_OBJECT
+public:
+    WaveformWorker(WaveformGenerator *generator, AudioChunkCache *cache);
+
+    // 把 url 解码成无文件头的单声道浮点 PCM（其他分析线程也复用）；
+    // loadOptions 是 loadfile 的单文件选项（如只解码一段：start=15,length=20），
+    // cancelled 返回 true 时中止，paused 返回 true 期间暂停解码
+    static bool decodePcm(const QString &url, const QString &pcmPath, int sampleRate, AudioChunkCache *cache,
+                          const QByteArray &loadOptions, const std::function<bool()> &cancelled,
+                          const std::function<bool()> &paused = std::function<bool()>());
+
+protected:
+    bool process(int songId, const QString &url, QVariant &result) override;
+
+private:
+    bool generate(const QString &url, Waveform &waveform);
+    static bool reduce(QIODevice &pcm, Waveform &waveform);
+};
+
+#endif // WAVEFORMWORKER_H